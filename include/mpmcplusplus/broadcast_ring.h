@@ -0,0 +1,369 @@
+/*
+ * broadcast_ring.h - Single producer broadcast ring for many subscribers
+ * Copyright (C) 2021 James Triantafylos
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MPMCPLUSPLUS_BROADCAST_RING_H
+#define MPMCPLUSPLUS_BROADCAST_RING_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "mpmcplusplus/detail.h"
+
+namespace mpmcplusplus {
+    /**
+     * What a BroadcastRing does when the producer catches up with a subscriber that has not read the oldest object.
+     */
+    enum class SlowSubscriberPolicy {
+        /**
+         * The producer waits for the subscriber, so every subscriber sees every object.
+         */
+        BLOCK_PRODUCER,
+
+        /**
+         * The subscriber is dropped and sees no further objects, so the producer never waits for it to catch up. If
+         * the subscriber is in the middle of copying the object that is about to be overwritten, the producer still
+         * waits for that one copy to finish, so a subscriber preempted mid-read stalls the producer until it resumes.
+         */
+        DROP_SUBSCRIBER
+    };
+
+    /**
+     * A fixed-capacity ring for exactly one producer thread that delivers every object to every subscriber.
+     *
+     * Each object is written into the ring once and every Subscriber keeps its own read cursor into it, so fanning out
+     * to many subscribers costs one copy per subscriber when it reads instead of one queue per subscriber. The producer
+     * only looks at the subscriber cursors once it has gone round the ring since it last did, and subscribers only
+     * touch their own cursor. Subscribers start with the first object pushed after they subscribed. What happens when
+     * the slowest subscriber is a whole ring behind is chosen with a SlowSubscriberPolicy. Calling push, emplace or
+     * wait_and_push from more than one thread at the same time is undefined behaviour, and all subscribers must be
+     * destroyed before the ring.
+     * @tparam T The type of object the ring will be storing. Must be copyable.
+     */
+    template <typename T>
+    class BroadcastRing {
+      private:
+        static constexpr std::uint64_t READING = 1;
+        static constexpr std::uint64_t DROPPED = 2;
+        static constexpr unsigned POSITION_SHIFT = 2;
+
+        struct Slot {
+            std::atomic<std::uint64_t> sequence;
+            typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+
+            Slot() : sequence(0) {}
+
+            T* object() { return reinterpret_cast<T*>(&storage); }
+        };
+
+      public:
+        /**
+         * A read cursor into a BroadcastRing. Each subscriber must only be used from one thread at a time.
+         */
+        class Subscriber {
+          private:
+            friend class BroadcastRing;
+
+            BroadcastRing& m_ring;
+            char m_pad_0[detail::CACHE_LINE_SIZE];
+            std::atomic<std::uint64_t> m_state;
+            char m_pad_1[detail::CACHE_LINE_SIZE];
+
+            bool try_pop(T& data) {
+                std::uint64_t state = m_state.load(std::memory_order_relaxed);
+                if ((state & DROPPED) != 0) {
+                    return false;
+                }
+                std::uint64_t position = state >> POSITION_SHIFT;
+                Slot& slot = m_ring.m_slots[position & m_ring.m_mask];
+                if (slot.sequence.load(std::memory_order_acquire) != position + 1) {
+                    return false;
+                }
+                // Announces the read so that a dropping producer waits for it instead of overwriting the slot.
+                if (!m_state.compare_exchange_strong(state, state | READING, std::memory_order_acquire)) {
+                    return false;
+                }
+                data = *slot.object();
+                m_state.store((position + 1) << POSITION_SHIFT, std::memory_order_release);
+                if (m_ring.m_policy == SlowSubscriberPolicy::BLOCK_PRODUCER) {
+                    m_ring.m_space_event_count.notify_one();
+                }
+                return true;
+            }
+
+          public:
+            /**
+             * Subscribes to the given ring.
+             * @param[in] ring The ring to read from.
+             */
+            explicit Subscriber(BroadcastRing& ring) : m_ring(ring), m_state(0) { m_ring.attach(this); }
+
+            Subscriber(const Subscriber&) = delete;
+            Subscriber& operator=(const Subscriber&) = delete;
+
+            ~Subscriber() { m_ring.detach(this); }
+
+            /**
+             * Returns whether the producer dropped this subscriber for falling a whole ring behind.
+             * @return true if the subscriber was dropped, otherwise false.
+             */
+            bool dropped() const { return (m_state.load(std::memory_order_acquire) & DROPPED) != 0; }
+
+            /**
+             * Reads the next object without blocking. This function will return immediately if the subscriber has
+             * read every pushed object or was dropped.
+             * @param[out] data A reference to where a copy of the object will be stored.
+             * @return true if an object was read, otherwise false.
+             */
+            bool pop(T& data) { return try_pop(data); }
+
+            /**
+             * Reads the next object. This function will wait indefinitely for an object to be pushed if the
+             * subscriber has read every pushed object.
+             * @param[out] data A reference to where a copy of the object will be stored.
+             * @return true if an object was read, otherwise false if the subscriber was dropped.
+             */
+            bool wait_and_pop(T& data) {
+                bool popped = false;
+                detail::wait_for_pop(m_ring.m_data_event_count,
+                                     [this, &data, &popped]() { return (popped = try_pop(data)) || dropped(); });
+                return popped;
+            }
+
+            /**
+             * Reads the next object. This function will wait for as long as the specified timeout for an object to be
+             * pushed if the subscriber has read every pushed object.
+             * @param[out] data A reference to where a copy of the object will be stored.
+             * @param[in] timeout A reference to a @c std::chrono::duration of how long this function should wait
+             * before returning.
+             * @return true if an object was read, otherwise false.
+             */
+            template <typename Rep, typename Period>
+            bool wait_and_pop(T& data, const std::chrono::duration<Rep, Period>& timeout) {
+                bool popped = false;
+                detail::wait_for_pop(
+                    m_ring.m_data_event_count,
+                    [this, &data, &popped]() { return (popped = try_pop(data)) || dropped(); },
+                    timeout);
+                return popped;
+            }
+        };
+
+      private:
+        const std::size_t m_mask;
+        const SlowSubscriberPolicy m_policy;
+        std::unique_ptr<Slot[]> m_slots;
+        char m_pad_0[detail::CACHE_LINE_SIZE];
+        std::atomic<std::uint64_t> m_tail;
+        std::uint64_t m_slowest;
+        char m_pad_1[detail::CACHE_LINE_SIZE];
+        std::mutex m_subscribers_mutex;
+        std::vector<Subscriber*> m_subscribers;
+        detail::EventCount m_data_event_count;
+        detail::EventCount m_space_event_count;
+
+        void attach(Subscriber* subscriber) {
+            std::lock_guard<std::mutex> lock(m_subscribers_mutex);
+            subscriber->m_state.store(m_tail.load(std::memory_order_acquire) << POSITION_SHIFT,
+                                      std::memory_order_relaxed);
+            m_subscribers.push_back(subscriber);
+        }
+
+        void detach(Subscriber* subscriber) {
+            {
+                std::lock_guard<std::mutex> lock(m_subscribers_mutex);
+                m_subscribers.erase(std::find(m_subscribers.begin(), m_subscribers.end(), subscriber));
+            }
+            m_space_event_count.notify_one();
+        }
+
+        // Waits for a read the subscriber has already started, because T may not be trivially copyable and a copy that
+        // races with the overwrite could not be detected and thrown away afterwards.
+        bool drop_if_lagging(Subscriber* subscriber, std::uint64_t tail) {
+            std::uint64_t state = subscriber->m_state.load(std::memory_order_acquire);
+            for (;;) {
+                if ((state & DROPPED) != 0) {
+                    return true;
+                }
+                if (tail - (state >> POSITION_SHIFT) <= m_mask) {
+                    return false;
+                }
+                if ((state & READING) != 0) {
+                    std::this_thread::yield();
+                    state = subscriber->m_state.load(std::memory_order_acquire);
+                } else if (subscriber->m_state.compare_exchange_weak(
+                               state, state | DROPPED, std::memory_order_acquire)) {
+                    return true;
+                }
+            }
+        }
+
+        bool has_room(std::uint64_t tail) {
+            if (tail - m_slowest <= m_mask) {
+                return true;
+            }
+            bool dropped = false;
+            std::uint64_t slowest = tail;
+            {
+                std::lock_guard<std::mutex> lock(m_subscribers_mutex);
+                for (Subscriber* subscriber : m_subscribers) {
+                    if (m_policy == SlowSubscriberPolicy::DROP_SUBSCRIBER && drop_if_lagging(subscriber, tail)) {
+                        dropped = true;
+                        continue;
+                    }
+                    std::uint64_t state = subscriber->m_state.load(std::memory_order_acquire);
+                    if ((state & DROPPED) == 0) {
+                        slowest = std::min(slowest, state >> POSITION_SHIFT);
+                    }
+                }
+            }
+            m_slowest = slowest;
+            if (dropped) {
+                m_data_event_count.notify_all();
+            }
+            return tail - m_slowest <= m_mask;
+        }
+
+        template <typename... Args>
+        void publish(std::uint64_t tail, Args&&... args) {
+            Slot& slot = m_slots[tail & m_mask];
+            if (slot.sequence.load(std::memory_order_relaxed) != 0) {
+                slot.sequence.store(0, std::memory_order_relaxed);
+                slot.object()->~T();
+            }
+            new (&slot.storage) T(std::forward<Args>(args)...);
+            slot.sequence.store(tail + 1, std::memory_order_release);
+            m_tail.store(tail + 1, std::memory_order_release);
+            m_data_event_count.notify_all();
+        }
+
+        template <typename... Args>
+        bool try_emplace(Args&&... args) {
+            std::uint64_t tail = m_tail.load(std::memory_order_relaxed);
+            if (!has_room(tail)) {
+                return false;
+            }
+            publish(tail, std::forward<Args>(args)...);
+            return true;
+        }
+
+        template <typename... Args>
+        bool wait_and_emplace(Args&&... args) {
+            std::uint64_t tail = m_tail.load(std::memory_order_relaxed);
+            detail::wait_for_pop(m_space_event_count, [this, tail]() { return has_room(tail); });
+            publish(tail, std::forward<Args>(args)...);
+            return true;
+        }
+
+      public:
+        /**
+         * Constructs an empty ring without subscribers.
+         * @param[in] capacity The minimum number of objects the ring can hold. It is rounded up to the next power of
+         * two.
+         * @param[in] policy What to do when the slowest subscriber is a whole ring behind the producer.
+         */
+        explicit BroadcastRing(std::size_t capacity,
+                               SlowSubscriberPolicy policy = SlowSubscriberPolicy::BLOCK_PRODUCER)
+            : m_mask(detail::round_up_to_power_of_two(capacity < 2 ? 2 : capacity) - 1),
+              m_policy(policy),
+              m_slots(new Slot[m_mask + 1]),
+              m_tail(0),
+              m_slowest(0) {}
+
+        BroadcastRing(const BroadcastRing&) = delete;
+        BroadcastRing& operator=(const BroadcastRing&) = delete;
+
+        ~BroadcastRing() {
+            for (std::size_t i = 0; i <= m_mask; ++i) {
+                if (m_slots[i].sequence.load(std::memory_order_relaxed) != 0) {
+                    m_slots[i].object()->~T();
+                }
+            }
+        }
+
+        /**
+         * Returns the number of objects the ring can hold.
+         * @return The capacity of the ring.
+         */
+        std::size_t capacity() const { return m_mask + 1; }
+
+        /**
+         * Pushes the given object to every subscriber. With SlowSubscriberPolicy::BLOCK_PRODUCER this function will
+         * return immediately if the slowest subscriber is a whole ring behind.
+         * @param[in] data The const lvalue reference to be pushed to the ring.
+         * @return true if an object was successfully pushed to the ring, otherwise false.
+         */
+        bool push(const T& data) { return try_emplace(data); }
+
+        /**
+         * Pushes the given object to every subscriber. With SlowSubscriberPolicy::BLOCK_PRODUCER this function will
+         * return immediately if the slowest subscriber is a whole ring behind.
+         * @param[in] data The rvalue reference to be pushed to the ring.
+         * @return true if an object was successfully pushed to the ring, otherwise false.
+         */
+        bool push(T&& data) { return try_emplace(std::move(data)); }
+
+        /**
+         * Pushes a new object to every subscriber. The object is constructed in-place. With
+         * SlowSubscriberPolicy::BLOCK_PRODUCER this function will return immediately if the slowest subscriber is a
+         * whole ring behind.
+         * @param[in] args The arguments to forward to the constructor of the object.
+         * @return true if an object was successfully emplaced in the ring, otherwise false.
+         */
+        template <typename... Args>
+        bool emplace(Args&&... args) {
+            return try_emplace(std::forward<Args>(args)...);
+        }
+
+        /**
+         * Pushes the given object to every subscriber. With SlowSubscriberPolicy::BLOCK_PRODUCER this function will
+         * wait indefinitely for the slowest subscriber to read an object if it is a whole ring behind.
+         * @param[in] data The const lvalue reference to be pushed to the ring.
+         * @return true if an object was successfully pushed to the ring, otherwise false.
+         */
+        bool wait_and_push(const T& data) { return wait_and_emplace(data); }
+
+        /**
+         * Pushes the given object to every subscriber. With SlowSubscriberPolicy::BLOCK_PRODUCER this function will
+         * wait indefinitely for the slowest subscriber to read an object if it is a whole ring behind.
+         * @param[in] data The rvalue reference to be pushed to the ring.
+         * @return true if an object was successfully pushed to the ring, otherwise false.
+         */
+        bool wait_and_push(T&& data) { return wait_and_emplace(std::move(data)); }
+    };
+
+    template <typename T>
+    constexpr std::uint64_t BroadcastRing<T>::READING;
+
+    template <typename T>
+    constexpr std::uint64_t BroadcastRing<T>::DROPPED;
+
+    template <typename T>
+    constexpr unsigned BroadcastRing<T>::POSITION_SHIFT;
+}
+
+#endif
@@ -0,0 +1,232 @@
+/*
+ * byte_ring.h - Variable-length byte message ring for Multi Producer Single Consumer communication
+ * Copyright (C) 2021 James Triantafylos
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MPMCPLUSPLUS_BYTE_RING_H
+#define MPMCPLUSPLUS_BYTE_RING_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+
+#include "mpmcplusplus/detail.h"
+
+namespace mpmcplusplus {
+    /**
+     * A fixed-capacity ring of variable-length byte messages for any number of producer threads and exactly one
+     * consumer thread.
+     *
+     * A producer reserves a contiguous region for a message, writes the message straight into the ring, and commits
+     * it. The consumer reads each message as one contiguous span inside the ring and releases it once it is done with
+     * it. Messages therefore cross the ring without any allocation and without being copied, as in a bip-buffer: a
+     * message that would wrap around the end of the ring is instead placed at the start, and the gap is skipped.
+     *
+     * The ring is made of 8-byte units, so every region is 8-byte aligned and takes up a whole number of units.
+     * Reserving is a single compare-and-swap on the tail. The state of each message is kept in an array of atomic
+     * headers beside the data, so producers may commit out of order; the consumer reads messages in reservation order
+     * and waits at the first one that has not been committed. A reserved region must always be committed. Calling
+     * read, wait_and_read or release from more than one thread at the same time is undefined behaviour.
+     */
+    class ByteRing {
+      private:
+        static constexpr std::size_t UNIT_SIZE = 8;
+        static constexpr std::uint32_t COMMITTED = static_cast<std::uint32_t>(1) << 31;
+        static constexpr std::uint32_t PADDING = static_cast<std::uint32_t>(1) << 30;
+        static constexpr std::uint32_t SIZE_MASK = PADDING - 1;
+
+        const std::size_t m_mask;
+        std::unique_ptr<std::uint64_t[]> m_units;
+        std::unique_ptr<std::atomic<std::uint32_t>[]> m_headers;
+        char m_pad_0[detail::CACHE_LINE_SIZE];
+        std::atomic<std::uint64_t> m_tail;
+        char m_pad_1[detail::CACHE_LINE_SIZE];
+        std::atomic<std::uint64_t> m_head;
+        char m_pad_2[detail::CACHE_LINE_SIZE];
+        detail::EventCount m_event_count;
+
+        static std::size_t units_for(std::size_t size) { return size == 0 ? 1 : (size + UNIT_SIZE - 1) / UNIT_SIZE; }
+
+        std::uint8_t* region(std::uint64_t unit) {
+            return reinterpret_cast<std::uint8_t*>(&m_units[static_cast<std::size_t>(unit & m_mask)]);
+        }
+
+        bool try_read(const std::uint8_t*& data, std::size_t& size) {
+            std::uint64_t head = m_head.load(std::memory_order_relaxed);
+            for (;;) {
+                std::atomic<std::uint32_t>& header = m_headers[static_cast<std::size_t>(head & m_mask)];
+                std::uint32_t state = header.load(std::memory_order_acquire);
+                if ((state & COMMITTED) == 0) {
+                    return false;
+                }
+                if ((state & PADDING) == 0) {
+                    data = region(head);
+                    size = state & SIZE_MASK;
+                    return true;
+                }
+                header.store(0, std::memory_order_relaxed);
+                head += state & SIZE_MASK;
+                m_head.store(head, std::memory_order_release);
+            }
+        }
+
+      public:
+        /**
+         * Constructs an empty ring.
+         * @param[in] capacity The minimum number of bytes the ring can hold. It is rounded up to the next power of two
+         * of at least 16.
+         */
+        explicit ByteRing(std::size_t capacity)
+            : m_mask(detail::round_up_to_power_of_two(units_for(capacity < 2 * UNIT_SIZE ? 2 * UNIT_SIZE : capacity)) -
+                     1),
+              m_units(new std::uint64_t[m_mask + 1]),
+              m_headers(new std::atomic<std::uint32_t>[m_mask + 1]),
+              m_tail(0),
+              m_head(0) {
+            for (std::size_t i = 0; i <= m_mask; ++i) {
+                m_headers[i].store(0, std::memory_order_relaxed);
+            }
+        }
+
+        ByteRing(const ByteRing&) = delete;
+        ByteRing& operator=(const ByteRing&) = delete;
+
+        /**
+         * Returns the number of bytes the ring can hold.
+         * @return The capacity of the ring.
+         */
+        std::size_t capacity() const { return (m_mask + 1) * UNIT_SIZE; }
+
+        /**
+         * Reserves a contiguous region for a message without blocking. This function will return immediately if the
+         * ring does not have room for the message.
+         * @param[in] size The size of the message in bytes. Must be at most the capacity of the ring.
+         * @return A pointer to the 8-byte aligned region that must be passed to commit() once the message has been
+         * written, or @c nullptr if the message does not fit.
+         */
+        std::uint8_t* reserve(std::size_t size) {
+            const std::uint64_t units = units_for(size);
+            if (units > m_mask + 1 || size > SIZE_MASK) {
+                return nullptr;
+            }
+            std::uint64_t tail = m_tail.load(std::memory_order_relaxed);
+            std::uint64_t padding;
+            do {
+                const std::uint64_t offset = tail & m_mask;
+                padding = offset + units > m_mask + 1 ? m_mask + 1 - offset : 0;
+                const std::uint64_t head = m_head.load(std::memory_order_acquire);
+                // An empty ring has every unit free. The skipped units at the end are never read, so the message may
+                // overlap them and any message up to the capacity fits no matter where the tail stands.
+                if (tail != head && tail + padding + units - head > m_mask + 1) {
+                    return nullptr;
+                }
+            } while (!m_tail.compare_exchange_weak(
+                tail, tail + padding + units, std::memory_order_relaxed, std::memory_order_relaxed));
+            if (padding != 0) {
+                m_headers[static_cast<std::size_t>(tail & m_mask)].store(
+                    COMMITTED | PADDING | static_cast<std::uint32_t>(padding), std::memory_order_release);
+                m_event_count.notify_one();
+            }
+            m_headers[static_cast<std::size_t>((tail + padding) & m_mask)].store(static_cast<std::uint32_t>(size),
+                                                                                 std::memory_order_relaxed);
+            return region(tail + padding);
+        }
+
+        /**
+         * Publishes a message that has been written into a region returned by reserve().
+         * @param[in] region The region returned by reserve().
+         */
+        void commit(std::uint8_t* region) {
+            const std::size_t unit =
+                static_cast<std::size_t>(reinterpret_cast<std::uint64_t*>(region) - m_units.get());
+            std::atomic<std::uint32_t>& header = m_headers[unit];
+            header.store(header.load(std::memory_order_relaxed) | COMMITTED, std::memory_order_release);
+            m_event_count.notify_one();
+        }
+
+        /**
+         * Copies the given bytes into the ring as one message without blocking. This function will return
+         * immediately if the ring does not have room for the message.
+         * @param[in] data The bytes of the message.
+         * @param[in] size The size of the message in bytes.
+         * @return true if the message was successfully pushed to the ring, otherwise false.
+         */
+        bool push(const void* data, std::size_t size) {
+            std::uint8_t* destination = reserve(size);
+            if (destination == nullptr) {
+                return false;
+            }
+            std::memcpy(destination, data, size);
+            commit(destination);
+            return true;
+        }
+
+        /**
+         * Looks at the oldest message without blocking. The message stays in the ring until release() is called.
+         * This function will return immediately if the oldest message has not been committed yet.
+         * @param[out] data A reference to where a pointer to the first byte of the message will be stored.
+         * @param[out] size A reference to where the size of the message in bytes will be stored.
+         * @return true if a message is available, otherwise false.
+         */
+        bool read(const std::uint8_t*& data, std::size_t& size) { return try_read(data, size); }
+
+        /**
+         * Looks at the oldest message. The message stays in the ring until release() is called. This function will
+         * wait indefinitely for the oldest message to be committed.
+         * @param[out] data A reference to where a pointer to the first byte of the message will be stored.
+         * @param[out] size A reference to where the size of the message in bytes will be stored.
+         * @return true if a message is available, otherwise false.
+         */
+        bool wait_and_read(const std::uint8_t*& data, std::size_t& size) {
+            detail::wait_for_pop(m_event_count, [this, &data, &size]() { return try_read(data, size); });
+            return true;
+        }
+
+        /**
+         * Looks at the oldest message. The message stays in the ring until release() is called. This function will
+         * wait for as long as the specified timeout for the oldest message to be committed.
+         * @param[out] data A reference to where a pointer to the first byte of the message will be stored.
+         * @param[out] size A reference to where the size of the message in bytes will be stored.
+         * @param[in] timeout A reference to a @c std::chrono::duration of how long this function should wait before
+         * returning.
+         * @return true if a message is available, otherwise false.
+         */
+        template <typename Rep, typename Period>
+        bool wait_and_read(const std::uint8_t*& data,
+                           std::size_t& size,
+                           const std::chrono::duration<Rep, Period>& timeout) {
+            return detail::wait_for_pop(
+                m_event_count, [this, &data, &size]() { return try_read(data, size); }, timeout);
+        }
+
+        /**
+         * Frees the message returned by the last successful read, making its space available to producers. Must
+         * only be called after a successful read, and the span of that read must not be used afterwards.
+         */
+        void release() {
+            const std::uint64_t head = m_head.load(std::memory_order_relaxed);
+            std::atomic<std::uint32_t>& header = m_headers[static_cast<std::size_t>(head & m_mask)];
+            const std::size_t units = units_for(header.load(std::memory_order_relaxed) & SIZE_MASK);
+            header.store(0, std::memory_order_relaxed);
+            m_head.store(head + units, std::memory_order_release);
+        }
+    };
+}
+
+#endif
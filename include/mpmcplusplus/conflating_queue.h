@@ -0,0 +1,181 @@
+/*
+ * conflating_queue.h - Key-conflating Multi Producer Multi Consumer queue implementation
+ * Copyright (C) 2021 James Triantafylos
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MPMCPLUSPLUS_CONFLATING_QUEUE_H
+#define MPMCPLUSPLUS_CONFLATING_QUEUE_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <unordered_map>
+#include <utility>
+
+namespace mpmcplusplus {
+    /**
+     * A queue of key-value pairs in which a pending value is replaced, rather than queued behind, when another value
+     * with the same key is pushed.
+     *
+     * Keys are queued in the order they were first pushed and each pending key maps to the latest value pushed for it.
+     * Pushing a value for a key that is already pending overwrites that value and leaves the key where it is in the
+     * queue, so consumers never see an obsolete value and the number of queued pairs is bounded by the number of
+     * distinct keys, no matter how bursty producers are. Once a pair has been popped, its key can be queued again.
+     * @tparam K The type of the keys. Must be copyable and hashable.
+     * @tparam V The type of the values.
+     * @tparam Hash The hash function for keys.
+     * @tparam KeyEqual The equality comparison for keys.
+     */
+    template <typename K, typename V, typename Hash = std::hash<K>, typename KeyEqual = std::equal_to<K>>
+    class ConflatingQueue {
+      private:
+        std::queue<K> m_keys;
+        std::unordered_map<K, V, Hash, KeyEqual> m_values;
+        mutable std::mutex m_mutex;
+        std::condition_variable m_condition_variable;
+
+        template <typename U>
+        bool insert(const K& key, U&& value) {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            if (!lock) {
+                return false;
+            }
+            typename std::unordered_map<K, V, Hash, KeyEqual>::iterator pending = m_values.find(key);
+            if (pending != m_values.end()) {
+                pending->second = std::forward<U>(value);
+                return true;
+            }
+            m_values.emplace(key, std::forward<U>(value));
+            m_keys.push(key);
+            lock.unlock();
+            m_condition_variable.notify_one();
+            return true;
+        }
+
+        void take_front(K& key, V& value) {
+            typename std::unordered_map<K, V, Hash, KeyEqual>::iterator pending = m_values.find(m_keys.front());
+            // The value goes first: if moving it throws, the key at the front still finds its pending value.
+            value = std::move(pending->second);
+            key = std::move(m_keys.front());
+            m_values.erase(pending);
+            m_keys.pop();
+        }
+
+      public:
+        /**
+         * Constructs an empty queue.
+         */
+        ConflatingQueue() {}
+
+        ConflatingQueue(const ConflatingQueue&) = delete;
+        ConflatingQueue& operator=(const ConflatingQueue&) = delete;
+
+        /**
+         * Returns the number of keys with a pending value.
+         * @return The size of the queue.
+         */
+        std::size_t size() const {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_keys.size();
+        }
+
+        /**
+         * Pushes the given value for the given key. If a value for the key is already pending it is replaced and the
+         * key keeps its position, otherwise the key is pushed to the back of the queue.
+         * @param[in] key The key the value belongs to.
+         * @param[in] value The const lvalue reference to be pushed to the queue.
+         * @return true if the value was successfully pushed to the queue, otherwise false.
+         */
+        bool push(const K& key, const V& value) { return insert(key, value); }
+
+        /**
+         * Pushes the given value for the given key. If a value for the key is already pending it is replaced and the
+         * key keeps its position, otherwise the key is pushed to the back of the queue.
+         * @param[in] key The key the value belongs to.
+         * @param[in] value The rvalue reference to be pushed to the queue.
+         * @return true if the value was successfully pushed to the queue, otherwise false.
+         */
+        bool push(const K& key, V&& value) { return insert(key, std::move(value)); }
+
+        /**
+         * Pops the key at the front of the queue together with its latest value without blocking. This function will
+         * return immediately if the queue is empty.
+         * @param[out] key A reference to where the popped key will be stored.
+         * @param[out] value A reference to where the popped value will be stored.
+         * @return true if a pair was popped from the front of the queue, otherwise false.
+         */
+        bool pop(K& key, V& value) {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            if (!lock) {
+                return false;
+            }
+            if (m_keys.empty()) {
+                return false;
+            }
+            take_front(key, value);
+            return true;
+        }
+
+        /**
+         * Pops the key at the front of the queue together with its latest value. This function will wait indefinitely
+         * for a value to be pushed to the queue if the queue is empty.
+         * @param[out] key A reference to where the popped key will be stored.
+         * @param[out] value A reference to where the popped value will be stored.
+         * @return true if a pair was popped from the front of the queue, otherwise false.
+         */
+        bool wait_and_pop(K& key, V& value) {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            if (!lock) {
+                return false;
+            }
+            while (m_keys.empty()) {
+                m_condition_variable.wait(lock);
+            }
+            take_front(key, value);
+            return true;
+        }
+
+        /**
+         * Pops the key at the front of the queue together with its latest value. This function will wait for as long
+         * as the specified timeout for a value to be pushed to the queue if the queue is empty.
+         * @param[out] key A reference to where the popped key will be stored.
+         * @param[out] value A reference to where the popped value will be stored.
+         * @param[in] timeout A reference to a @c std::chrono::duration of how long this function should wait before
+         * returning.
+         * @return true if a pair was popped from the front of the queue, otherwise false.
+         */
+        template <typename Rep, typename Period>
+        bool wait_and_pop(K& key, V& value, const std::chrono::duration<Rep, Period>& timeout) {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            if (!lock) {
+                return false;
+            }
+            while (m_keys.empty()) {
+                std::cv_status result = m_condition_variable.wait_for(lock, timeout);
+                if (result == std::cv_status::timeout) {
+                    return false;
+                }
+            }
+            take_front(key, value);
+            return true;
+        }
+    };
+}
+
+#endif
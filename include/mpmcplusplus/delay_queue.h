@@ -0,0 +1,368 @@
+/*
+ * delay_queue.h - Delay queue implementation backed by a hierarchical timing wheel
+ * Copyright (C) 2021 James Triantafylos
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MPMCPLUSPLUS_DELAY_QUEUE_H
+#define MPMCPLUSPLUS_DELAY_QUEUE_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <queue>
+#include <utility>
+#include <vector>
+
+#include "mpmcplusplus/detail.h"
+
+namespace mpmcplusplus {
+    /**
+     * A thread-safe queue whose objects only become available once their deadline has passed.
+     *
+     * Pending objects are kept in a hierarchical timing wheel of four levels with 64 slots each, so inserting an
+     * object and expiring it are both constant time regardless of how many objects are pending. Time is measured in
+     * ticks of a configurable resolution; an object is never handed out before its deadline, but may be handed out up
+     * to one tick after it. Consumers blocked in wait_and_pop sleep until the next slot of the wheel that holds
+     * objects comes due, or until a push gives them something earlier to wait for, instead of polling.
+     * @tparam T The type of object the queue will be storing.
+     */
+    template <typename T>
+    class DelayQueue {
+      public:
+        /**
+         * The clock deadlines are measured against.
+         */
+        typedef std::chrono::steady_clock Clock;
+
+      private:
+        static constexpr unsigned SLOT_BITS = 6;
+        static constexpr std::size_t SLOT_COUNT = static_cast<std::size_t>(1) << SLOT_BITS;
+        static constexpr unsigned LEVEL_COUNT = 4;
+        static constexpr std::uint64_t SLOT_MASK = SLOT_COUNT - 1;
+        static constexpr std::uint64_t NO_TICK = ~static_cast<std::uint64_t>(0);
+
+        struct Entry {
+            std::uint64_t due_tick;
+            T data;
+
+            template <typename... Args>
+            explicit Entry(std::uint64_t tick, Args&&... args) : due_tick(tick), data(std::forward<Args>(args)...) {}
+        };
+
+        struct Level {
+            std::vector<Entry> slots[SLOT_COUNT];
+            std::uint64_t occupied;
+
+            Level() : occupied(0) {}
+        };
+
+        const Clock::time_point m_start;
+        const Clock::duration m_resolution;
+        std::uint64_t m_current_tick;
+        Level m_levels[LEVEL_COUNT];
+        std::vector<Entry> m_overflow;
+        std::queue<T> m_ready;
+        mutable std::mutex m_mutex;
+        std::condition_variable m_condition_variable;
+
+        static unsigned shift(unsigned level) { return SLOT_BITS * level; }
+
+        std::uint64_t due_tick(const Clock::time_point& deadline) const {
+            if (deadline <= m_start) {
+                return 0;
+            }
+            // Round up so that an object is never handed out before its deadline.
+            return static_cast<std::uint64_t>((deadline - m_start + m_resolution - Clock::duration(1)) / m_resolution);
+        }
+
+        std::uint64_t current_tick(const Clock::time_point& now) const {
+            return now <= m_start ? 0 : static_cast<std::uint64_t>((now - m_start) / m_resolution);
+        }
+
+        Clock::time_point tick_time(std::uint64_t tick) const {
+            return m_start + m_resolution * static_cast<Clock::rep>(tick);
+        }
+
+        void insert(Entry&& entry) {
+            if (entry.due_tick <= m_current_tick) {
+                m_ready.push(std::move(entry.data));
+                return;
+            }
+            // An object lives on the lowest level whose slot digits are the only ones in which its due tick differs
+            // from the current tick, so each cascade moves it exactly one level down.
+            unsigned level = 0;
+            while (level < LEVEL_COUNT &&
+                   (entry.due_tick >> shift(level + 1)) != (m_current_tick >> shift(level + 1))) {
+                ++level;
+            }
+            if (level == LEVEL_COUNT) {
+                m_overflow.push_back(std::move(entry));
+                return;
+            }
+            const std::size_t slot = static_cast<std::size_t>((entry.due_tick >> shift(level)) & SLOT_MASK);
+            m_levels[level].slots[slot].push_back(std::move(entry));
+            m_levels[level].occupied |= static_cast<std::uint64_t>(1) << slot;
+        }
+
+        void reinsert(std::vector<Entry>& entries) {
+            std::vector<Entry> moved;
+            moved.swap(entries);
+            for (Entry& entry : moved) {
+                insert(std::move(entry));
+            }
+            // Hand the storage back so the slot does not have to allocate again the next time it fills up.
+            moved.clear();
+            if (entries.empty()) {
+                entries.swap(moved);
+            }
+        }
+
+        void cascade() {
+            if ((m_current_tick & ((static_cast<std::uint64_t>(1) << shift(LEVEL_COUNT)) - 1)) == 0 &&
+                !m_overflow.empty()) {
+                reinsert(m_overflow);
+            }
+            for (unsigned level = LEVEL_COUNT - 1; level > 0; --level) {
+                if ((m_current_tick & ((static_cast<std::uint64_t>(1) << shift(level)) - 1)) != 0) {
+                    continue;
+                }
+                const std::size_t slot = static_cast<std::size_t>((m_current_tick >> shift(level)) & SLOT_MASK);
+                const std::uint64_t bit = static_cast<std::uint64_t>(1) << slot;
+                if ((m_levels[level].occupied & bit) == 0) {
+                    continue;
+                }
+                m_levels[level].occupied &= ~bit;
+                reinsert(m_levels[level].slots[slot]);
+            }
+        }
+
+        void expire() {
+            const std::size_t slot = static_cast<std::size_t>(m_current_tick & SLOT_MASK);
+            std::vector<Entry>& entries = m_levels[0].slots[slot];
+            for (Entry& entry : entries) {
+                m_ready.push(std::move(entry.data));
+            }
+            entries.clear();
+            m_levels[0].occupied &= ~(static_cast<std::uint64_t>(1) << slot);
+        }
+
+        // Returns the set bits of the given level's occupancy that lie after the current tick's digit on that level.
+        std::uint64_t occupied_after_current(unsigned level) const {
+            const unsigned digit = static_cast<unsigned>((m_current_tick >> shift(level)) & SLOT_MASK);
+            if (digit == SLOT_MASK) {
+                return 0;
+            }
+            return m_levels[level].occupied & (~static_cast<std::uint64_t>(0) << (digit + 1));
+        }
+
+        // Returns the first tick after the current one at which the wheel has work to do, or NO_TICK if it is empty.
+        std::uint64_t next_event_tick() const {
+            for (unsigned level = 0; level < LEVEL_COUNT; ++level) {
+                const std::uint64_t bits = occupied_after_current(level);
+                if (bits != 0) {
+                    const std::uint64_t base = (m_current_tick >> shift(level + 1)) << shift(level + 1);
+                    return base + (static_cast<std::uint64_t>(detail::count_trailing_zeros(bits)) << shift(level));
+                }
+            }
+            if (!m_overflow.empty()) {
+                return ((m_current_tick >> shift(LEVEL_COUNT)) + 1) << shift(LEVEL_COUNT);
+            }
+            return NO_TICK;
+        }
+
+        void advance(std::uint64_t target_tick) {
+            while (m_current_tick < target_tick) {
+                // Nothing happens between now and the next occupied slot or pending cascade, so idle time is skipped
+                // in a single step however long it was.
+                const std::uint64_t next_tick = next_event_tick();
+                if (next_tick > target_tick) {
+                    m_current_tick = target_tick;
+                    return;
+                }
+                m_current_tick = next_tick;
+                if ((m_current_tick & SLOT_MASK) == 0) {
+                    cascade();
+                }
+                expire();
+            }
+        }
+
+        template <typename... Args>
+        bool schedule(const Clock::time_point& deadline, Args&&... args) {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            if (!lock) {
+                return false;
+            }
+            const Clock::time_point now = Clock::now();
+            advance(current_tick(now));
+            if (deadline <= now) {
+                m_ready.emplace(std::forward<Args>(args)...);
+            } else {
+                insert(Entry(due_tick(deadline), std::forward<Args>(args)...));
+            }
+            lock.unlock();
+            m_condition_variable.notify_one();
+            return true;
+        }
+
+        // Wakes another consumer if objects are still ready, since a single push may have made several of them due.
+        void pass_on_ready(std::unique_lock<std::mutex>& lock) {
+            const bool ready = !m_ready.empty();
+            lock.unlock();
+            if (ready) {
+                m_condition_variable.notify_one();
+            }
+        }
+
+        bool pop_ready(T& data) {
+            advance(current_tick(Clock::now()));
+            if (m_ready.empty()) {
+                return false;
+            }
+            data = std::move(m_ready.front());
+            m_ready.pop();
+            return true;
+        }
+
+      public:
+        /**
+         * Constructs an empty queue.
+         * @param[in] resolution The length of one tick of the timing wheel. Objects may be handed out up to this long
+         * after their deadline.
+         */
+        explicit DelayQueue(Clock::duration resolution = std::chrono::milliseconds(1))
+            : m_start(Clock::now()),
+              m_resolution(resolution > Clock::duration::zero() ? resolution : Clock::duration(1)),
+              m_current_tick(0) {}
+
+        DelayQueue(const DelayQueue&) = delete;
+        DelayQueue& operator=(const DelayQueue&) = delete;
+
+        /**
+         * Pushes the given object to the queue. It becomes available to consumers once the deadline has passed.
+         * @param[in] data The const lvalue reference to be pushed to the queue.
+         * @param[in] deadline The point in time before which the object must not be popped.
+         * @return true if an object was successfully pushed to the queue, otherwise false.
+         */
+        bool push(const T& data, const Clock::time_point& deadline) { return schedule(deadline, data); }
+
+        /**
+         * Pushes the given object to the queue. It becomes available to consumers once the deadline has passed.
+         * @param[in] data The rvalue reference to be pushed to the queue.
+         * @param[in] deadline The point in time before which the object must not be popped.
+         * @return true if an object was successfully pushed to the queue, otherwise false.
+         */
+        bool push(T&& data, const Clock::time_point& deadline) { return schedule(deadline, std::move(data)); }
+
+        /**
+         * Pushes a new object to the queue. The object is constructed in-place and becomes available to consumers once
+         * the deadline has passed.
+         * @param[in] deadline The point in time before which the object must not be popped.
+         * @param[in] args The arguments to forward to the constructor of the object.
+         * @return true if an object was successfully emplaced in the queue, otherwise false.
+         */
+        template <typename... Args>
+        bool emplace(const Clock::time_point& deadline, Args&&... args) {
+            return schedule(deadline, std::forward<Args>(args)...);
+        }
+
+        /**
+         * Pops an object whose deadline has passed without blocking. This function will return immediately if no
+         * object is due yet.
+         * @param[out] data A reference to where the popped object will be stored.
+         * @return true if an object was popped from the queue, otherwise false.
+         */
+        bool pop(T& data) {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            if (!lock) {
+                return false;
+            }
+            if (!pop_ready(data)) {
+                return false;
+            }
+            pass_on_ready(lock);
+            return true;
+        }
+
+        /**
+         * Pops an object whose deadline has passed. This function will wait indefinitely for an object to become due
+         * if none is due yet.
+         * @param[out] data A reference to where the popped object will be stored.
+         * @return true if an object was popped from the queue, otherwise false.
+         */
+        bool wait_and_pop(T& data) {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            if (!lock) {
+                return false;
+            }
+            while (!pop_ready(data)) {
+                const std::uint64_t next_tick = next_event_tick();
+                if (next_tick == NO_TICK) {
+                    m_condition_variable.wait(lock);
+                } else {
+                    m_condition_variable.wait_until(lock, tick_time(next_tick));
+                }
+            }
+            pass_on_ready(lock);
+            return true;
+        }
+
+        /**
+         * Pops an object whose deadline has passed. This function will wait for as long as the specified timeout for
+         * an object to become due if none is due yet.
+         * @param[out] data A reference to where the popped object will be stored.
+         * @param[in] timeout A reference to a @c std::chrono::duration of how long this function should wait before
+         * returning.
+         * @return true if an object was popped from the queue, otherwise false.
+         */
+        template <typename Rep, typename Period>
+        bool wait_and_pop(T& data, const std::chrono::duration<Rep, Period>& timeout) {
+            const Clock::time_point give_up = Clock::now() + std::chrono::duration_cast<Clock::duration>(timeout);
+            std::unique_lock<std::mutex> lock(m_mutex);
+            if (!lock) {
+                return false;
+            }
+            while (!pop_ready(data)) {
+                if (Clock::now() >= give_up) {
+                    return false;
+                }
+                const std::uint64_t next_tick = next_event_tick();
+                Clock::time_point wake_up = give_up;
+                if (next_tick != NO_TICK && tick_time(next_tick) < give_up) {
+                    wake_up = tick_time(next_tick);
+                }
+                m_condition_variable.wait_until(lock, wake_up);
+            }
+            pass_on_ready(lock);
+            return true;
+        }
+    };
+
+    template <typename T>
+    constexpr unsigned DelayQueue<T>::SLOT_BITS;
+    template <typename T>
+    constexpr std::size_t DelayQueue<T>::SLOT_COUNT;
+    template <typename T>
+    constexpr unsigned DelayQueue<T>::LEVEL_COUNT;
+    template <typename T>
+    constexpr std::uint64_t DelayQueue<T>::SLOT_MASK;
+    template <typename T>
+    constexpr std::uint64_t DelayQueue<T>::NO_TICK;
+}
+
+#endif
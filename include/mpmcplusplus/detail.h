@@ -0,0 +1,563 @@
+/*
+ * detail.h - Internal helpers shared by the mpmcplusplus containers
+ * Copyright (C) 2021 James Triantafylos
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MPMCPLUSPLUS_DETAIL_H
+#define MPMCPLUSPLUS_DETAIL_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <type_traits>
+
+namespace mpmcplusplus {
+    /**
+     * Implementation details of mpmcplusplus. Nothing in this namespace is part of the public interface.
+     */
+    namespace detail {
+        /**
+         * The assumed size of a cache line. Hot atomics that are written by different threads are kept at least this
+         * far apart so that they do not share a line.
+         */
+        constexpr std::size_t CACHE_LINE_SIZE = 64;
+
+        /**
+         * Rounds the given value up to the next power of two.
+         * @param[in] value The value to round up.
+         * @return The smallest power of two that is greater than or equal to @p value, or 1 if @p value is 0.
+         */
+        inline std::size_t round_up_to_power_of_two(std::size_t value) {
+            std::size_t result = 1;
+            while (result < value) {
+                result <<= 1;
+            }
+            return result;
+        }
+
+        /**
+         * Maps any well-formed list of types to void. Used to detect members in partial specializations.
+         */
+        template <typename...>
+        struct make_void {
+            typedef void type;
+        };
+
+        /**
+         * The capacity imposed by a queue storage policy. Storage policies that can only hold a fixed number of objects
+         * advertise it through a static @c capacity member; all others are treated as unbounded.
+         * @tparam Storage The storage policy to inspect.
+         */
+        template <typename Storage, typename = void>
+        struct storage_capacity : std::integral_constant<std::size_t, ~static_cast<std::size_t>(0)> {};
+
+        template <typename Storage>
+        struct storage_capacity<Storage, typename make_void<decltype(Storage::capacity)>::type>
+            : std::integral_constant<std::size_t, Storage::capacity> {};
+
+        /**
+         * Counts the number of trailing zero bits in the given value.
+         * @param[in] value The value to inspect. Must not be 0.
+         * @return The index of the lowest set bit of @p value.
+         */
+        inline unsigned count_trailing_zeros(std::uint64_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+            return static_cast<unsigned>(__builtin_ctzll(value));
+#else
+            unsigned count = 0;
+            while ((value & 1) == 0) {
+                value >>= 1;
+                ++count;
+            }
+            return count;
+#endif
+        }
+
+        /**
+         * Counts the number of leading zero bits in the given value.
+         * @param[in] value The value to inspect. Must not be 0.
+         * @return The number of bits above the highest set bit of @p value.
+         */
+        inline unsigned count_leading_zeros(std::uint64_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+            return static_cast<unsigned>(__builtin_clzll(value));
+#else
+            unsigned count = 0;
+            while ((value & (static_cast<std::uint64_t>(1) << 63)) == 0) {
+                value <<= 1;
+                ++count;
+            }
+            return count;
+#endif
+        }
+
+        /**
+         * Returns a small number that is unique to the calling thread. Numbers are handed out in the order threads
+         * first call this function, which makes them suitable for spreading threads over a fixed set of shards.
+         * @return The index of the calling thread.
+         */
+        inline std::size_t thread_index() {
+            static std::atomic<std::size_t> next_index(0);
+            thread_local std::size_t index = next_index.fetch_add(1, std::memory_order_relaxed);
+            return index;
+        }
+
+        /**
+         * Returns a pseudo-random number from a generator private to the calling thread. The generator is a cheap
+         * xorshift that is only meant for spreading load, not for anything that needs good statistical properties.
+         * @param[in] bound The exclusive upper bound of the returned number. Must not be 0.
+         * @return A number in the range [0, @p bound).
+         */
+        inline std::size_t random_index(std::size_t bound) {
+            thread_local std::uint64_t state = 0x9E3779B97F4A7C15ull * (thread_index() + 1);
+            state ^= state << 13;
+            state ^= state >> 7;
+            state ^= state << 17;
+            return static_cast<std::size_t>(state % bound);
+        }
+
+        /**
+         * An event count used to park consumers of the lock-free containers.
+         *
+         * A waiter announces itself with prepare_wait(), re-checks its condition, and only then calls wait(). A
+         * notifier that has already published its change calls notify_one() or notify_all(), which only touch the
+         * mutex when somebody is actually waiting. This keeps the uncontended path free of locks and system calls.
+         */
+        class EventCount {
+          private:
+            std::atomic<std::size_t> m_waiters;
+            std::atomic<std::uint64_t> m_epoch;
+            std::mutex m_mutex;
+            std::condition_variable m_condition_variable;
+
+            void notify(bool all) {
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                if (m_waiters.load(std::memory_order_relaxed) == 0) {
+                    return;
+                }
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    m_epoch.fetch_add(1, std::memory_order_relaxed);
+                }
+                if (all) {
+                    m_condition_variable.notify_all();
+                } else {
+                    m_condition_variable.notify_one();
+                }
+            }
+
+          public:
+            EventCount() : m_waiters(0), m_epoch(0) {}
+
+            EventCount(const EventCount&) = delete;
+            EventCount& operator=(const EventCount&) = delete;
+
+            /**
+             * Registers the calling thread as a waiter. Must be followed by exactly one call to either wait(),
+             * wait_until() or cancel_wait().
+             * @return The key to pass to wait() or wait_until().
+             */
+            std::uint64_t prepare_wait() {
+                m_waiters.fetch_add(1, std::memory_order_seq_cst);
+                // Pairs with the fence in notify() so that either the waiter sees the published change when it
+                // re-checks its condition or the notifier sees the waiter.
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                return m_epoch.load(std::memory_order_seq_cst);
+            }
+
+            /**
+             * Unregisters a waiter whose condition became true after prepare_wait().
+             */
+            void cancel_wait() { m_waiters.fetch_sub(1, std::memory_order_seq_cst); }
+
+            /**
+             * Blocks until a notification is issued after the matching prepare_wait().
+             * @param[in] key The key returned by prepare_wait().
+             */
+            void wait(std::uint64_t key) {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                while (m_epoch.load(std::memory_order_relaxed) == key) {
+                    m_condition_variable.wait(lock);
+                }
+                m_waiters.fetch_sub(1, std::memory_order_seq_cst);
+            }
+
+            /**
+             * Blocks until a notification is issued after the matching prepare_wait() or the deadline passes.
+             * @param[in] key The key returned by prepare_wait().
+             * @param[in] deadline The point in time after which this function gives up waiting.
+             * @return true if a notification was received, otherwise false.
+             */
+            template <typename Clock, typename Duration>
+            bool wait_until(std::uint64_t key, const std::chrono::time_point<Clock, Duration>& deadline) {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                bool notified = true;
+                while (m_epoch.load(std::memory_order_relaxed) == key) {
+                    if (m_condition_variable.wait_until(lock, deadline) == std::cv_status::timeout) {
+                        notified = m_epoch.load(std::memory_order_relaxed) != key;
+                        break;
+                    }
+                }
+                m_waiters.fetch_sub(1, std::memory_order_seq_cst);
+                return notified;
+            }
+
+            /**
+             * Wakes up one waiting thread, if any.
+             */
+            void notify_one() { notify(false); }
+
+            /**
+             * Wakes up every waiting thread, if any.
+             */
+            void notify_all() { notify(true); }
+        };
+
+        /**
+         * A node that has been unlinked from a lock-free container and is waiting to be deleted by a reclaimer.
+         */
+        struct RetiredObject {
+            void* object;
+            void (*deleter)(void*);
+            std::uint64_t epoch;
+
+            template <typename U>
+            static void delete_object(void* object) {
+                delete static_cast<U*>(object);
+            }
+
+            template <typename U>
+            RetiredObject(U* object, std::uint64_t epoch = 0)
+                : object(object), deleter(&delete_object<U>), epoch(epoch) {}
+
+            void destroy() { deleter(object); }
+        };
+
+        /**
+         * The per-thread records of a reclamation domain, kept in a lock-free list that only ever grows until the
+         * domain is destroyed. A record is owned by one thread at a time for the duration of a guard and then released
+         * for reuse, so the retired objects it holds outlive the thread that retired them. Each thread remembers the
+         * last record it used in a few recently used domains to avoid scanning the list on every operation.
+         * @tparam Record The record type. It must have an @c std::atomic<bool> @c in_use member that is true after
+         * construction and a @c Record* @c next member.
+         */
+        template <typename Record>
+        class RecordList {
+          private:
+            static constexpr std::size_t HINT_COUNT = 4;
+
+            struct Hint {
+                std::uint64_t list;
+                Record* record;
+            };
+
+            const std::uint64_t m_id;
+            std::atomic<Record*> m_head;
+
+            static std::uint64_t next_id() {
+                static std::atomic<std::uint64_t> id(0);
+                return id.fetch_add(1, std::memory_order_relaxed) + 1;
+            }
+
+            static bool try_claim(Record* record) {
+                return !record->in_use.load(std::memory_order_relaxed) &&
+                       !record->in_use.exchange(true, std::memory_order_acquire);
+            }
+
+          public:
+            RecordList() : m_id(next_id()), m_head(nullptr) {}
+
+            RecordList(const RecordList&) = delete;
+            RecordList& operator=(const RecordList&) = delete;
+
+            ~RecordList() {
+                Record* record = m_head.load(std::memory_order_acquire);
+                while (record != nullptr) {
+                    Record* next = record->next;
+                    delete record;
+                    record = next;
+                }
+            }
+
+            /**
+             * Claims a record for the calling thread, creating a new one if all of them are in use.
+             * @return A record that is owned by the calling thread until it is passed to release().
+             */
+            Record* acquire() {
+                thread_local Hint hints[HINT_COUNT] = {};
+                Hint& hint = hints[m_id % HINT_COUNT];
+                if (hint.list == m_id && try_claim(hint.record)) {
+                    return hint.record;
+                }
+                Record* record = m_head.load(std::memory_order_acquire);
+                while (record != nullptr && !try_claim(record)) {
+                    record = record->next;
+                }
+                if (record == nullptr) {
+                    record = new Record();
+                    record->next = m_head.load(std::memory_order_relaxed);
+                    while (!m_head.compare_exchange_weak(
+                        record->next, record, std::memory_order_release, std::memory_order_relaxed)) {
+                    }
+                }
+                hint.list = m_id;
+                hint.record = record;
+                return record;
+            }
+
+            /**
+             * Gives up ownership of a record claimed with acquire().
+             * @param[in] record The record to release.
+             */
+            void release(Record* record) { record->in_use.store(false, std::memory_order_release); }
+
+            /**
+             * Returns the most recently created record. The others are reached through their @c next members.
+             * @return The first record of the list, or @c nullptr if there is none.
+             */
+            Record* head() const { return m_head.load(std::memory_order_acquire); }
+        };
+
+        template <typename Record>
+        constexpr std::size_t RecordList<Record>::HINT_COUNT;
+
+        /**
+         * A fixed set of independently locked sub-queues for the relaxed containers. A push locks a random sub-queue
+         * whose lock is free, and a pop takes the better front of two random sub-queues, only reporting the set as
+         * empty after checking every sub-queue. Threads therefore rarely meet on the same lock, at the price of a
+         * relaxed order.
+         * @tparam SubQueue The sub-queue type. It must have an @c std::mutex @c mutex member, a @c has_objects()
+         * member that may be called without the lock as a hint, and @c empty() and @c pop(data) members that are
+         * called with the lock held.
+         */
+        template <typename SubQueue>
+        class SubQueueSet {
+          private:
+            typedef typename std::aligned_storage<sizeof(SubQueue), alignof(SubQueue)>::type Slot;
+
+            const std::size_t m_count;
+            std::unique_ptr<Slot[]> m_slots;
+            std::size_t m_constructed;
+
+            SubQueue& sub_queue(std::size_t index) { return *reinterpret_cast<SubQueue*>(&m_slots[index]); }
+
+            void destroy_sub_queues() {
+                while (m_constructed != 0) {
+                    sub_queue(--m_constructed).~SubQueue();
+                }
+            }
+
+            template <typename T>
+            static bool try_pop_one(SubQueue& queue, T& data) {
+                std::unique_lock<std::mutex> lock(queue.mutex, std::try_to_lock);
+                if (!lock || queue.empty()) {
+                    return false;
+                }
+                queue.pop(data);
+                return true;
+            }
+
+            template <typename T, typename Before>
+            bool try_pop_two_choices(T& data, Before before) {
+                SubQueue& first = sub_queue(random_index(m_count));
+                SubQueue& second = sub_queue(random_index(m_count));
+                if (&first == &second || !first.has_objects() || !second.has_objects()) {
+                    return try_pop_one(first.has_objects() ? first : second, data);
+                }
+                std::unique_lock<std::mutex> first_lock(first.mutex, std::try_to_lock);
+                if (!first_lock) {
+                    return false;
+                }
+                std::unique_lock<std::mutex> second_lock(second.mutex, std::try_to_lock);
+                if (!second_lock || second.empty()) {
+                    if (first.empty()) {
+                        return false;
+                    }
+                    first.pop(data);
+                    return true;
+                }
+                if (first.empty() || !before(first, second)) {
+                    second.pop(data);
+                } else {
+                    first.pop(data);
+                }
+                return true;
+            }
+
+          public:
+            /**
+             * Constructs a set of empty sub-queues.
+             * @param[in] count The number of sub-queues. Zero is treated as one.
+             * @param[in] args The arguments every sub-queue is constructed with, such as a comparator.
+             */
+            template <typename... Args>
+            explicit SubQueueSet(std::size_t count, const Args&... args)
+                : m_count(count == 0 ? 1 : count), m_slots(new Slot[m_count]), m_constructed(0) {
+                try {
+                    for (; m_constructed < m_count; ++m_constructed) {
+                        new (&m_slots[m_constructed]) SubQueue(args...);
+                    }
+                } catch (...) {
+                    destroy_sub_queues();
+                    throw;
+                }
+            }
+
+            SubQueueSet(const SubQueueSet&) = delete;
+            SubQueueSet& operator=(const SubQueueSet&) = delete;
+
+            ~SubQueueSet() { destroy_sub_queues(); }
+
+            /**
+             * Returns the number of sub-queues in the set.
+             * @return The sub-queue count.
+             */
+            std::size_t count() const { return m_count; }
+
+            /**
+             * Returns the sub-queue at the given index without locking it.
+             * @param[in] index The index of the sub-queue, less than count().
+             * @return The sub-queue.
+             */
+            SubQueue& operator[](std::size_t index) { return sub_queue(index); }
+
+            /**
+             * Locks a random sub-queue for a push, preferring one whose lock is free and blocking on the last one
+             * tried if every attempt finds its lock taken.
+             * @param[out] lock The lock to take. It owns the mutex of the returned sub-queue on return.
+             * @return The locked sub-queue.
+             */
+            SubQueue& lock_random(std::unique_lock<std::mutex>& lock) {
+                SubQueue* queue = nullptr;
+                for (std::size_t attempt = 0; attempt < m_count; ++attempt) {
+                    queue = &sub_queue(random_index(m_count));
+                    lock = std::unique_lock<std::mutex>(queue->mutex, std::try_to_lock);
+                    if (lock) {
+                        return *queue;
+                    }
+                }
+                lock = std::unique_lock<std::mutex>(queue->mutex);
+                return *queue;
+            }
+
+            /**
+             * Pops the better of the fronts of two random sub-queues without blocking.
+             * @param[out] data A reference to where the popped object will be stored.
+             * @param[in] before A predicate called with both locks held on two non-empty sub-queues. It returns true
+             * if the front of the first one should be popped rather than the front of the second one.
+             * @return true if an object was popped, otherwise false if every sub-queue was empty.
+             */
+            template <typename T, typename Before>
+            bool try_pop(T& data, Before before) {
+                for (std::size_t attempt = 0; attempt < 2; ++attempt) {
+                    if (try_pop_two_choices(data, before)) {
+                        return true;
+                    }
+                }
+                // The random choices keep missing, so fall back to a full scan before reporting the set as empty.
+                for (std::size_t i = 0; i < m_count; ++i) {
+                    SubQueue& queue = sub_queue(i);
+                    if (!queue.has_objects()) {
+                        continue;
+                    }
+                    std::unique_lock<std::mutex> lock(queue.mutex);
+                    if (queue.empty()) {
+                        continue;
+                    }
+                    queue.pop(data);
+                    return true;
+                }
+                return false;
+            }
+        };
+
+        /**
+         * The batch size from which waking every waiting thread is cheaper than waking them one at a time.
+         */
+        constexpr std::size_t NOTIFY_ALL_THRESHOLD = 8;
+
+        /**
+         * Wakes up as many waiting threads as there are new objects. Small batches wake one thread per object and
+         * batches of at least NOTIFY_ALL_THRESHOLD objects wake every waiting thread.
+         * @tparam Notifiable A type with @c notify_one and @c notify_all members, such as EventCount or a condition
+         * variable.
+         * @param[in] notifiable The object to notify through.
+         * @param[in] count The number of new objects.
+         */
+        template <typename Notifiable>
+        void notify_count(Notifiable& notifiable, std::size_t count) {
+            if (count >= NOTIFY_ALL_THRESHOLD) {
+                notifiable.notify_all();
+                return;
+            }
+            for (std::size_t i = 0; i < count; ++i) {
+                notifiable.notify_one();
+            }
+        }
+
+        /**
+         * Repeatedly calls @p try_pop until it succeeds, parking on @p event_count while it fails.
+         * @tparam Event EventCount or another type with the same prepare_wait, cancel_wait and wait members.
+         * @param[in] event_count The event count that producers notify after publishing an object.
+         * @param[in] try_pop A callable returning true once an object has been popped.
+         */
+        template <typename Event, typename TryPop>
+        void wait_for_pop(Event& event_count, TryPop try_pop) {
+            while (!try_pop()) {
+                std::uint64_t key = event_count.prepare_wait();
+                if (try_pop()) {
+                    event_count.cancel_wait();
+                    return;
+                }
+                event_count.wait(key);
+            }
+        }
+
+        /**
+         * Repeatedly calls @p try_pop until it succeeds or @p timeout elapses, parking on @p event_count while it
+         * fails.
+         * @tparam Event EventCount or another type with the same prepare_wait, cancel_wait and wait_until members.
+         * @param[in] event_count The event count that producers notify after publishing an object.
+         * @param[in] try_pop A callable returning true once an object has been popped.
+         * @param[in] timeout How long to wait in total before giving up.
+         * @return true if @p try_pop succeeded, otherwise false.
+         */
+        template <typename Event, typename TryPop, typename Rep, typename Period>
+        bool wait_for_pop(Event& event_count, TryPop try_pop, const std::chrono::duration<Rep, Period>& timeout) {
+            const std::chrono::steady_clock::time_point deadline =
+                std::chrono::steady_clock::now() +
+                std::chrono::duration_cast<std::chrono::steady_clock::duration>(timeout);
+            while (!try_pop()) {
+                std::uint64_t key = event_count.prepare_wait();
+                if (try_pop()) {
+                    event_count.cancel_wait();
+                    return true;
+                }
+                if (!event_count.wait_until(key, deadline)) {
+                    return try_pop();
+                }
+            }
+            return true;
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,180 @@
+/*
+ * epoch_reclaimer.h - Epoch-based memory reclamation for lock-free containers
+ * Copyright (C) 2021 James Triantafylos
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MPMCPLUSPLUS_EPOCH_RECLAIMER_H
+#define MPMCPLUSPLUS_EPOCH_RECLAIMER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "mpmcplusplus/detail.h"
+
+namespace mpmcplusplus {
+    /**
+     * An epoch-based reclamation domain that node-based lock-free containers use to free unlinked nodes safely.
+     *
+     * Every operation on the container runs inside a Guard, which pins the calling thread to the current global epoch.
+     * Nodes unlinked by the operation are retired into a list private to the guard's thread record, tagged with the
+     * epoch they were retired in. Only once such a list has collected a batch of nodes does the retiring thread try to
+     * advance the global epoch and free the nodes that were retired two epochs ago, at which point no guard can still
+     * be holding a reference to them. Entering and leaving a guard therefore costs a few uncontended atomic operations
+     * on the thread's own record, and scanning for garbage is amortised over a whole batch.
+     *
+     * Garbage is bounded by the batch size per thread record for as long as every guard is short-lived. A thread that
+     * is descheduled while holding a guard stops the epoch from advancing, and nodes pile up until it resumes.
+     */
+    class EpochReclaimer {
+      public:
+        /**
+         * The number of nodes a thread record collects on top of those it could not free the last time before it tries
+         * to free any of them.
+         */
+        static constexpr std::size_t RETIRE_BATCH_SIZE = 64;
+
+      private:
+        static constexpr std::uint64_t ACTIVE = 1;
+
+        struct Record {
+            std::atomic<std::uint64_t> epoch;
+            std::atomic<bool> in_use;
+            Record* next;
+            std::vector<detail::RetiredObject> retired;
+            std::size_t collect_threshold;
+            char pad[detail::CACHE_LINE_SIZE];
+
+            Record() : epoch(0), in_use(true), next(nullptr), collect_threshold(RETIRE_BATCH_SIZE) {
+                retired.reserve(RETIRE_BATCH_SIZE * 2);
+            }
+
+            ~Record() {
+                for (std::size_t i = 0; i < retired.size(); ++i) {
+                    retired[i].destroy();
+                }
+            }
+        };
+
+        char m_pad_0[detail::CACHE_LINE_SIZE];
+        std::atomic<std::uint64_t> m_epoch;
+        char m_pad_1[detail::CACHE_LINE_SIZE];
+        detail::RecordList<Record> m_records;
+
+        bool try_advance(std::uint64_t epoch) {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            const std::uint64_t pinned = (epoch << 1) | ACTIVE;
+            for (Record* record = m_records.head(); record != nullptr; record = record->next) {
+                std::uint64_t local = record->epoch.load(std::memory_order_acquire);
+                if ((local & ACTIVE) != 0 && local != pinned) {
+                    return false;
+                }
+            }
+            return m_epoch.compare_exchange_strong(epoch, epoch + 1, std::memory_order_seq_cst);
+        }
+
+        void collect(Record* record) {
+            std::uint64_t epoch = m_epoch.load(std::memory_order_seq_cst);
+            if (try_advance(epoch)) {
+                ++epoch;
+            }
+            std::vector<detail::RetiredObject>& retired = record->retired;
+            std::size_t kept = 0;
+            for (std::size_t i = 0; i < retired.size(); ++i) {
+                if (retired[i].epoch + 2 <= epoch) {
+                    retired[i].destroy();
+                } else {
+                    retired[kept++] = retired[i];
+                }
+            }
+            retired.erase(retired.begin() + kept, retired.end());
+            // While a stalled guard holds the epoch back nothing can be freed, so wait for another batch before trying
+            // again rather than rescanning the records on every retire.
+            record->collect_threshold = kept + RETIRE_BATCH_SIZE;
+        }
+
+      public:
+        /**
+         * A critical region during which nodes loaded from the container are guaranteed not to be freed. Guards are
+         * cheap and meant to cover exactly one container operation.
+         */
+        class Guard {
+          private:
+            EpochReclaimer& m_reclaimer;
+            Record* m_record;
+
+          public:
+            /**
+             * Pins the calling thread to the current epoch of the given domain.
+             * @param[in] reclaimer The domain of the container being operated on.
+             */
+            explicit Guard(EpochReclaimer& reclaimer)
+                : m_reclaimer(reclaimer), m_record(reclaimer.m_records.acquire()) {
+                std::uint64_t epoch = m_reclaimer.m_epoch.load(std::memory_order_seq_cst);
+                m_record->epoch.store((epoch << 1) | ACTIVE, std::memory_order_relaxed);
+                // Pairs with the fence in try_advance() so that the epoch cannot move on twice while this guard loads
+                // pointers that were published before it.
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+            }
+
+            Guard(const Guard&) = delete;
+            Guard& operator=(const Guard&) = delete;
+
+            ~Guard() {
+                m_record->epoch.store(0, std::memory_order_release);
+                m_reclaimer.m_records.release(m_record);
+            }
+
+            /**
+             * Loads a pointer from the container. With epochs the guard already protects every node it can reach, so
+             * this is a plain acquire load; it exists so that containers can be written against any reclaimer.
+             * @param[in] index Unused by this reclaimer.
+             * @param[in] source The atomic pointer to load.
+             * @return The loaded pointer, which stays valid until the guard is destroyed.
+             */
+            template <typename U>
+            U* protect(std::size_t index, const std::atomic<U*>& source) {
+                (void)index;
+                return source.load(std::memory_order_acquire);
+            }
+
+            /**
+             * Hands a node that has been unlinked from the container over to the domain. It is deleted once no guard
+             * that might have loaded it is left.
+             * @param[in] object The unlinked node, allocated with @c new.
+             */
+            template <typename U>
+            void retire(U* object) {
+                m_record->retired.push_back(
+                    detail::RetiredObject(object, m_reclaimer.m_epoch.load(std::memory_order_seq_cst)));
+                if (m_record->retired.size() >= m_record->collect_threshold) {
+                    m_reclaimer.collect(m_record);
+                }
+            }
+        };
+
+        /**
+         * Constructs an empty domain.
+         */
+        EpochReclaimer() : m_epoch(0) {}
+
+        EpochReclaimer(const EpochReclaimer&) = delete;
+        EpochReclaimer& operator=(const EpochReclaimer&) = delete;
+    };
+}
+
+#endif
@@ -0,0 +1,181 @@
+/*
+ * hazard_pointer_reclaimer.h - Hazard pointer memory reclamation for lock-free containers
+ * Copyright (C) 2021 James Triantafylos
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MPMCPLUSPLUS_HAZARD_POINTER_RECLAIMER_H
+#define MPMCPLUSPLUS_HAZARD_POINTER_RECLAIMER_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+#include "mpmcplusplus/detail.h"
+
+namespace mpmcplusplus {
+    /**
+     * A hazard pointer reclamation domain that node-based lock-free containers use to free unlinked nodes safely.
+     *
+     * Instead of pinning a whole epoch, a Guard publishes each node it is about to dereference in one of its hazard
+     * slots and re-checks that the node is still reachable. Retired nodes are collected in a list private to the
+     * guard's thread record, and once it has grown by a batch the retiring thread frees every node that no slot
+     * currently points to. A thread that stalls inside a guard therefore only holds back the few nodes in its own
+     * slots, and each thread record never holds more than the batch size plus the number of hazard slots in the
+     * domain, however long a guard lives. The price is a fence on every protected load.
+     */
+    class HazardPointerReclaimer {
+      public:
+        /**
+         * The number of nodes a thread record collects on top of the hazard slots of the domain before it tries to
+         * free any of them.
+         */
+        static constexpr std::size_t RETIRE_BATCH_SIZE = 64;
+
+        /**
+         * The number of pointers a single guard can protect at once.
+         */
+        static constexpr std::size_t SLOT_COUNT = 2;
+
+      private:
+        struct Record {
+            std::atomic<void*> hazards[SLOT_COUNT];
+            std::atomic<bool> in_use;
+            Record* next;
+            std::vector<detail::RetiredObject> retired;
+            std::vector<void*> scanned;
+            std::size_t scan_threshold;
+            char pad[detail::CACHE_LINE_SIZE];
+
+            Record() : in_use(true), next(nullptr), scan_threshold(RETIRE_BATCH_SIZE) {
+                for (std::size_t i = 0; i < SLOT_COUNT; ++i) {
+                    hazards[i].store(nullptr, std::memory_order_relaxed);
+                }
+                retired.reserve(RETIRE_BATCH_SIZE * 2);
+            }
+
+            ~Record() {
+                for (std::size_t i = 0; i < retired.size(); ++i) {
+                    retired[i].destroy();
+                }
+            }
+        };
+
+        detail::RecordList<Record> m_records;
+
+        void collect(Record* record) {
+            // Pairs with the fence in Guard::protect() so that a guard either sees the node unlinked or publishes its
+            // hazard before this scan reads it.
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            std::vector<void*>& scanned = record->scanned;
+            scanned.clear();
+            for (Record* other = m_records.head(); other != nullptr; other = other->next) {
+                for (std::size_t i = 0; i < SLOT_COUNT; ++i) {
+                    void* hazard = other->hazards[i].load(std::memory_order_acquire);
+                    if (hazard != nullptr) {
+                        scanned.push_back(hazard);
+                    }
+                }
+            }
+            std::sort(scanned.begin(), scanned.end());
+
+            std::vector<detail::RetiredObject>& retired = record->retired;
+            std::size_t kept = 0;
+            for (std::size_t i = 0; i < retired.size(); ++i) {
+                if (std::binary_search(scanned.begin(), scanned.end(), retired[i].object)) {
+                    retired[kept++] = retired[i];
+                } else {
+                    retired[i].destroy();
+                }
+            }
+            retired.erase(retired.begin() + kept, retired.end());
+            record->scan_threshold = kept + RETIRE_BATCH_SIZE;
+        }
+
+      public:
+        /**
+         * A critical region during which the nodes protected through it are guaranteed not to be freed. Guards are
+         * meant to cover exactly one container operation.
+         */
+        class Guard {
+          private:
+            HazardPointerReclaimer& m_reclaimer;
+            Record* m_record;
+
+          public:
+            /**
+             * Claims a set of hazard slots in the given domain.
+             * @param[in] reclaimer The domain of the container being operated on.
+             */
+            explicit Guard(HazardPointerReclaimer& reclaimer)
+                : m_reclaimer(reclaimer), m_record(reclaimer.m_records.acquire()) {}
+
+            Guard(const Guard&) = delete;
+            Guard& operator=(const Guard&) = delete;
+
+            ~Guard() {
+                for (std::size_t i = 0; i < SLOT_COUNT; ++i) {
+                    m_record->hazards[i].store(nullptr, std::memory_order_release);
+                }
+                m_reclaimer.m_records.release(m_record);
+            }
+
+            /**
+             * Loads a pointer from the container and protects the node it points to in the given slot, replacing
+             * whatever that slot protected before.
+             * @param[in] index The hazard slot to use. Must be less than @c SLOT_COUNT.
+             * @param[in] source The atomic pointer to load.
+             * @return The loaded pointer, which stays valid until the slot is reused or the guard is destroyed.
+             */
+            template <typename U>
+            U* protect(std::size_t index, const std::atomic<U*>& source) {
+                U* pointer = source.load(std::memory_order_relaxed);
+                for (;;) {
+                    m_record->hazards[index].store(pointer, std::memory_order_relaxed);
+                    std::atomic_thread_fence(std::memory_order_seq_cst);
+                    U* current = source.load(std::memory_order_acquire);
+                    if (current == pointer) {
+                        return pointer;
+                    }
+                    pointer = current;
+                }
+            }
+
+            /**
+             * Hands a node that has been unlinked from the container over to the domain. It is deleted once no hazard
+             * slot points to it.
+             * @param[in] object The unlinked node, allocated with @c new.
+             */
+            template <typename U>
+            void retire(U* object) {
+                m_record->retired.push_back(detail::RetiredObject(object));
+                if (m_record->retired.size() >= m_record->scan_threshold) {
+                    m_reclaimer.collect(m_record);
+                }
+            }
+        };
+
+        /**
+         * Constructs an empty domain.
+         */
+        HazardPointerReclaimer() {}
+
+        HazardPointerReclaimer(const HazardPointerReclaimer&) = delete;
+        HazardPointerReclaimer& operator=(const HazardPointerReclaimer&) = delete;
+    };
+}
+
+#endif
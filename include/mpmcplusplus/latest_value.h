@@ -0,0 +1,179 @@
+/*
+ * latest_value.h - Conflating Single Producer Single Consumer mailbox implementation
+ * Copyright (C) 2021 James Triantafylos
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MPMCPLUSPLUS_LATEST_VALUE_H
+#define MPMCPLUSPLUS_LATEST_VALUE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "mpmcplusplus/detail.h"
+
+namespace mpmcplusplus {
+    /**
+     * A mailbox for exactly one producer thread and one consumer thread that only keeps the most recent object.
+     *
+     * The mailbox is a triple buffer. The producer writes into a back buffer it owns and publishes it by exchanging it
+     * with the shared middle buffer, and the consumer takes the middle buffer by exchanging it with the front buffer it
+     * owns. Pushing overwrites an object the consumer has not taken yet, so the producer never waits for the consumer
+     * to make room, and popping is a single exchange no matter how many objects were pushed in the meantime. A push is
+     * lock-free unless the consumer is parked in wait_and_pop, in which case it briefly takes a mutex and wakes the
+     * consumer up. Calling push or emplace from more than one thread, or pop or wait_and_pop from more than one thread,
+     * at the same time is undefined behaviour.
+     * @tparam T The type of object the mailbox will be storing.
+     */
+    template <typename T>
+    class LatestValue {
+      private:
+        static constexpr std::uint8_t INDEX_MASK = 3;
+        static constexpr std::uint8_t FRESH = 4;
+
+        struct Buffer {
+            typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+            bool constructed;
+            char pad[detail::CACHE_LINE_SIZE];
+
+            Buffer() : constructed(false) {}
+
+            T* object() { return reinterpret_cast<T*>(&storage); }
+        };
+
+        Buffer m_buffers[3];
+        char m_pad_0[detail::CACHE_LINE_SIZE];
+        std::atomic<std::uint8_t> m_middle;
+        char m_pad_1[detail::CACHE_LINE_SIZE];
+        std::uint8_t m_back;
+        char m_pad_2[detail::CACHE_LINE_SIZE];
+        std::uint8_t m_front;
+        char m_pad_3[detail::CACHE_LINE_SIZE];
+        detail::EventCount m_event_count;
+
+        template <typename... Args>
+        bool publish(Args&&... args) {
+            Buffer& buffer = m_buffers[m_back];
+            if (buffer.constructed) {
+                buffer.constructed = false;
+                buffer.object()->~T();
+            }
+            new (&buffer.storage) T(std::forward<Args>(args)...);
+            buffer.constructed = true;
+            const std::uint8_t published = static_cast<std::uint8_t>(m_back | FRESH);
+            m_back = m_middle.exchange(published, std::memory_order_acq_rel) & INDEX_MASK;
+            m_event_count.notify_one();
+            return true;
+        }
+
+        bool try_pop(T& data) {
+            if ((m_middle.load(std::memory_order_relaxed) & FRESH) == 0) {
+                return false;
+            }
+            m_front = m_middle.exchange(m_front, std::memory_order_acq_rel) & INDEX_MASK;
+            data = std::move(*m_buffers[m_front].object());
+            return true;
+        }
+
+      public:
+        /**
+         * Constructs an empty mailbox.
+         */
+        LatestValue() : m_middle(1), m_back(0), m_front(2) {}
+
+        LatestValue(const LatestValue&) = delete;
+        LatestValue& operator=(const LatestValue&) = delete;
+
+        ~LatestValue() {
+            for (Buffer& buffer : m_buffers) {
+                if (buffer.constructed) {
+                    buffer.object()->~T();
+                }
+            }
+        }
+
+        /**
+         * Replaces the object in the mailbox with the given object. Never waits for the consumer, but takes a
+         * mutex to wake it up if it is parked. Must only be called from the producer thread.
+         * @param[in] data The const lvalue reference to be pushed to the mailbox.
+         * @return true if an object was successfully pushed to the mailbox, otherwise false.
+         */
+        bool push(const T& data) { return publish(data); }
+
+        /**
+         * Replaces the object in the mailbox with the given object. Never waits for the consumer, but takes a
+         * mutex to wake it up if it is parked. Must only be called from the producer thread.
+         * @param[in] data The rvalue reference to be pushed to the mailbox.
+         * @return true if an object was successfully pushed to the mailbox, otherwise false.
+         */
+        bool push(T&& data) { return publish(std::move(data)); }
+
+        /**
+         * Replaces the object in the mailbox with a new object. The object is constructed in-place. Never waits for
+         * the consumer, but takes a mutex to wake it up if it is parked. Must only be called from the producer thread.
+         * @param[in] args The arguments to forward to the constructor of the object.
+         * @return true if an object was successfully emplaced in the mailbox, otherwise false.
+         */
+        template <typename... Args>
+        bool emplace(Args&&... args) {
+            return publish(std::forward<Args>(args)...);
+        }
+
+        /**
+         * Takes the most recently pushed object without blocking. Objects that were overwritten before they could be
+         * taken are never returned. This function will return immediately if no object was pushed since the last pop.
+         * Must only be called from the consumer thread.
+         * @param[out] data A reference to where the popped object will be stored.
+         * @return true if an object was popped from the mailbox, otherwise false.
+         */
+        bool pop(T& data) { return try_pop(data); }
+
+        /**
+         * Takes the most recently pushed object. This function will wait indefinitely for an object to be pushed if
+         * none was pushed since the last pop. Must only be called from the consumer thread.
+         * @param[out] data A reference to where the popped object will be stored.
+         * @return true if an object was popped from the mailbox, otherwise false.
+         */
+        bool wait_and_pop(T& data) {
+            detail::wait_for_pop(m_event_count, [this, &data]() { return try_pop(data); });
+            return true;
+        }
+
+        /**
+         * Takes the most recently pushed object. This function will wait for as long as the specified timeout for an
+         * object to be pushed if none was pushed since the last pop. Must only be called from the consumer thread.
+         * @param[out] data A reference to where the popped object will be stored.
+         * @param[in] timeout A reference to a @c std::chrono::duration of how long this function should wait before
+         * returning.
+         * @return true if an object was popped from the mailbox, otherwise false.
+         */
+        template <typename Rep, typename Period>
+        bool wait_and_pop(T& data, const std::chrono::duration<Rep, Period>& timeout) {
+            return detail::wait_for_pop(m_event_count, [this, &data]() { return try_pop(data); }, timeout);
+        }
+    };
+
+    template <typename T>
+    constexpr std::uint8_t LatestValue<T>::INDEX_MASK;
+
+    template <typename T>
+    constexpr std::uint8_t LatestValue<T>::FRESH;
+}
+
+#endif
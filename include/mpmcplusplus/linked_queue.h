@@ -0,0 +1,201 @@
+/*
+ * linked_queue.h - Unbounded lock-free Multi Producer Multi Consumer linked queue implementation
+ * Copyright (C) 2021 James Triantafylos
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MPMCPLUSPLUS_LINKED_QUEUE_H
+#define MPMCPLUSPLUS_LINKED_QUEUE_H
+
+#include <atomic>
+#include <chrono>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "mpmcplusplus/detail.h"
+#include "mpmcplusplus/epoch_reclaimer.h"
+
+namespace mpmcplusplus {
+    /**
+     * An unbounded, lock-free queue for any number of producer and consumer threads, built as a Michael-Scott linked
+     * list.
+     *
+     * Producers link a new node after the tail with a compare-and-swap and consumers unlink the front node the same
+     * way, helping each other swing a lagging tail along. Unlinked nodes may still be read by other threads, so they
+     * are handed to a reclaimer instead of being deleted on the spot.
+     * @tparam T The type of object the queue will be storing.
+     * @tparam Reclaimer The memory reclamation scheme that frees unlinked nodes. It must provide a nested @c Guard
+     * constructed from the reclaimer, with @c protect(index, source) and @c retire(node) members. Two protection slots
+     * are used.
+     */
+    template <typename T, typename Reclaimer = EpochReclaimer>
+    class LinkedQueue {
+      private:
+        struct Node {
+            std::atomic<Node*> next;
+            typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+
+            Node() : next(nullptr) {}
+
+            T* object() { return reinterpret_cast<T*>(&storage); }
+        };
+
+        typedef typename Reclaimer::Guard Guard;
+
+        char m_pad_0[detail::CACHE_LINE_SIZE];
+        std::atomic<Node*> m_tail;
+        char m_pad_1[detail::CACHE_LINE_SIZE];
+        std::atomic<Node*> m_head;
+        char m_pad_2[detail::CACHE_LINE_SIZE];
+        Reclaimer m_reclaimer;
+        detail::EventCount m_event_count;
+
+        template <typename... Args>
+        bool link(Args&&... args) {
+            Node* node = new Node();
+            try {
+                new (&node->storage) T(std::forward<Args>(args)...);
+            } catch (...) {
+                delete node;
+                throw;
+            }
+            Guard guard(m_reclaimer);
+            for (;;) {
+                Node* tail = guard.protect(0, m_tail);
+                Node* next = tail->next.load(std::memory_order_acquire);
+                if (tail != m_tail.load(std::memory_order_acquire)) {
+                    continue;
+                }
+                if (next != nullptr) {
+                    m_tail.compare_exchange_weak(tail, next, std::memory_order_release, std::memory_order_relaxed);
+                    continue;
+                }
+                if (tail->next.compare_exchange_weak(
+                        next, node, std::memory_order_release, std::memory_order_relaxed)) {
+                    m_tail.compare_exchange_strong(tail, node, std::memory_order_release, std::memory_order_relaxed);
+                    break;
+                }
+            }
+            m_event_count.notify_one();
+            return true;
+        }
+
+        bool try_pop(T& data) {
+            Guard guard(m_reclaimer);
+            for (;;) {
+                Node* head = guard.protect(0, m_head);
+                Node* next = guard.protect(1, head->next);
+                if (head != m_head.load(std::memory_order_acquire)) {
+                    continue;
+                }
+                if (next == nullptr) {
+                    return false;
+                }
+                Node* tail = m_tail.load(std::memory_order_acquire);
+                if (head == tail) {
+                    m_tail.compare_exchange_weak(tail, next, std::memory_order_release, std::memory_order_relaxed);
+                    continue;
+                }
+                if (m_head.compare_exchange_weak(head, next, std::memory_order_acq_rel, std::memory_order_relaxed)) {
+                    // Winning the exchange makes next the new stub and hands its object to this thread alone.
+                    data = std::move(*next->object());
+                    next->object()->~T();
+                    guard.retire(head);
+                    return true;
+                }
+            }
+        }
+
+      public:
+        /**
+         * Constructs an empty queue.
+         */
+        LinkedQueue() : m_tail(new Node()), m_head(m_tail.load(std::memory_order_relaxed)) {}
+
+        LinkedQueue(const LinkedQueue&) = delete;
+        LinkedQueue& operator=(const LinkedQueue&) = delete;
+
+        ~LinkedQueue() {
+            Node* head = m_head.load(std::memory_order_relaxed);
+            Node* next = head->next.load(std::memory_order_relaxed);
+            delete head;
+            while (next != nullptr) {
+                Node* node = next;
+                next = node->next.load(std::memory_order_relaxed);
+                node->object()->~T();
+                delete node;
+            }
+        }
+
+        /**
+         * Pushes the given object to the back of the queue.
+         * @param[in] data The const lvalue reference to be pushed to the queue.
+         * @return true if an object was successfully pushed to the queue, otherwise false.
+         */
+        bool push(const T& data) { return link(data); }
+
+        /**
+         * Pushes the given object to the back of the queue.
+         * @param[in] data The rvalue reference to be pushed to the queue.
+         * @return true if an object was successfully pushed to the queue, otherwise false.
+         */
+        bool push(T&& data) { return link(std::move(data)); }
+
+        /**
+         * Pushes a new object to the back of the queue. The object is constructed in-place.
+         * @param[in] args The arguments to forward to the constructor of the object.
+         * @return true if an object was successfully emplaced in the queue, otherwise false.
+         */
+        template <typename... Args>
+        bool emplace(Args&&... args) {
+            return link(std::forward<Args>(args)...);
+        }
+
+        /**
+         * Pops an object from the front of the queue without blocking. This function will return immediately if the
+         * queue is empty.
+         * @param[out] data A reference to where the popped object will be stored.
+         * @return true if an object was popped from the front of the queue, otherwise false.
+         */
+        bool pop(T& data) { return try_pop(data); }
+
+        /**
+         * Pops an object from the front of the queue. This function will wait indefinitely for an object to be pushed
+         * to the queue if the queue is empty.
+         * @param[out] data A reference to where the popped object will be stored.
+         * @return true if an object was popped from the front of the queue, otherwise false.
+         */
+        bool wait_and_pop(T& data) {
+            detail::wait_for_pop(m_event_count, [this, &data]() { return try_pop(data); });
+            return true;
+        }
+
+        /**
+         * Pops an object from the front of the queue. This function will wait for as long as the specified timeout for
+         * an object to be pushed to the queue if the queue is empty.
+         * @param[out] data A reference to where the popped object will be stored.
+         * @param[in] timeout A reference to a @c std::chrono::duration of how long this function should wait before
+         * returning.
+         * @return true if an object was popped from the front of the queue, otherwise false.
+         */
+        template <typename Rep, typename Period>
+        bool wait_and_pop(T& data, const std::chrono::duration<Rep, Period>& timeout) {
+            return detail::wait_for_pop(m_event_count, [this, &data]() { return try_pop(data); }, timeout);
+        }
+    };
+}
+
+#endif
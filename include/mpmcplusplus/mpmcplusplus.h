@@ -19,76 +19,319 @@
 #ifndef MPSCPLUSPLUS_H
 #define MPSCPLUSPLUS_H
 
+#include <algorithm>
+#include <chrono>
 #include <condition_variable>
+#include <cstddef>
+#include <iterator>
+#include <limits>
 #include <mutex>
 #include <queue>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#include "mpmcplusplus/policies.h"
 
 /**
  * The namespace encapsulating all mpmcplusplus functionality.
  */
 namespace mpmcplusplus {
+    namespace detail {
+        struct SelectAccess;
+    }
+
     /**
      * A wrapper structure around std::queue to allow for thread-safe operations.
-     * Uses a @c std::mutex and a @c std::condition_variable to accomplish this.
+     * By default uses a @c std::mutex and a @c std::condition_variable to accomplish this.
+     *
+     * The queue can optionally be given a capacity. Once it holds that many objects, push and emplace fail and
+     * wait_and_push and wait_and_emplace block until a consumer makes room, pushing backpressure onto producers
+     * instead of letting the queue grow without limit.
+     *
+     * The backing storage, the lock and the way blocked threads wait are all chosen at compile time through policy
+     * parameters, so a queue can for example use a RingBuffer, a SpinLock and FutexWait without any virtual dispatch.
+     * The defaults give the behaviour described above.
      * @tparam T The type of object the queue will be storing.
+     * @tparam StoragePolicy The FIFO container holding the objects. Must provide @c push, @c emplace, @c front, @c pop,
+     * @c empty and @c size with the same meaning as @c std::queue. drain and wait_and_drain additionally need @c swap.
+     * @tparam LockPolicy The lock guarding the storage. Must meet the @c Lockable requirements.
+     * @tparam WaitPolicy The way blocked threads wait. Must provide a member template @c waiter<LockPolicy> with
+     * @c wait, @c wait_for, @c notify_one and @c notify_all with the same meaning as @c std::condition_variable.
      */
-    template <typename T>
+    template <typename T,
+              typename StoragePolicy = std::queue<T>,
+              typename LockPolicy = std::mutex,
+              typename WaitPolicy = ConditionVariableWait>
     class Queue {
+      public:
+        /**
+         * The type of object the queue is storing.
+         */
+        typedef T value_type;
+
+        /**
+         * The type of container the queue stores its objects in.
+         */
+        typedef StoragePolicy storage_type;
+
       private:
-        std::queue<T> m_backing_queue;
-        mutable std::mutex m_mutex;
-        std::condition_variable m_condition_variable;
+        friend struct detail::SelectAccess;
+
+        typedef typename WaitPolicy::template waiter<LockPolicy> Waiter;
+
+        StoragePolicy m_backing_queue;
+        const std::size_t m_capacity;
+        mutable LockPolicy m_mutex;
+        Waiter m_condition_variable;
+        Waiter m_not_full_condition_variable;
+        std::vector<detail::EventCount*> m_listeners;
+
+        bool is_bounded() const { return m_capacity != std::numeric_limits<std::size_t>::max(); }
+
+        bool is_full() const { return m_backing_queue.size() >= m_capacity; }
+
+        void notify_not_full(std::size_t count = 1) {
+            if (is_bounded()) {
+                detail::notify_count(m_not_full_condition_variable, count);
+            }
+        }
+
+        void notify_pushed(std::unique_lock<LockPolicy>& lock, std::size_t count = 1) {
+            for (detail::EventCount* listener : m_listeners) {
+                detail::notify_count(*listener, count);
+            }
+            lock.unlock();
+            detail::notify_count(m_condition_variable, count);
+        }
+
+        // Announces the objects pushed so far when it goes out of scope, even if a later push in the batch threw.
+        class BulkPushGuard {
+          private:
+            Queue& m_queue;
+            std::unique_lock<LockPolicy>& m_lock;
+
+          public:
+            std::size_t count;
+
+            BulkPushGuard(Queue& queue, std::unique_lock<LockPolicy>& lock) : m_queue(queue), m_lock(lock), count(0) {}
+
+            BulkPushGuard(const BulkPushGuard&) = delete;
+            BulkPushGuard& operator=(const BulkPushGuard&) = delete;
+
+            ~BulkPushGuard() {
+                if (count != 0) {
+                    m_queue.notify_pushed(m_lock, count);
+                }
+            }
+        };
+
+        void add_listener(detail::EventCount* listener) {
+            std::lock_guard<LockPolicy> lock(m_mutex);
+            m_listeners.push_back(listener);
+        }
+
+        void remove_listener(detail::EventCount* listener) {
+            std::lock_guard<LockPolicy> lock(m_mutex);
+            m_listeners.erase(std::find(m_listeners.begin(), m_listeners.end(), listener));
+        }
+
+        template <typename... Args>
+        bool wait_for_space_and_emplace(Args&&... args) {
+            std::unique_lock<LockPolicy> lock(m_mutex);
+            if (!lock) {
+                return false;
+            }
+            while (is_full()) {
+                m_not_full_condition_variable.wait(lock);
+            }
+            m_backing_queue.emplace(std::forward<Args>(args)...);
+            notify_pushed(lock);
+            return true;
+        }
+
+        template <typename Rep, typename Period, typename... Args>
+        bool wait_for_space_and_emplace_for(const std::chrono::duration<Rep, Period>& timeout, Args&&... args) {
+            std::unique_lock<LockPolicy> lock(m_mutex);
+            if (!lock) {
+                return false;
+            }
+            while (is_full()) {
+                std::cv_status result = m_not_full_condition_variable.wait_for(lock, timeout);
+                if (result == std::cv_status::timeout) {
+                    return false;
+                }
+            }
+            m_backing_queue.emplace(std::forward<Args>(args)...);
+            notify_pushed(lock);
+            return true;
+        }
+
+        template <typename OutputIt>
+        std::size_t pop_front(OutputIt out, std::size_t max) {
+            std::size_t count = 0;
+            while (count < max && !m_backing_queue.empty()) {
+                *out = std::move(m_backing_queue.front());
+                ++out;
+                m_backing_queue.pop();
+                ++count;
+            }
+            return count;
+        }
 
       public:
         /**
-         * Pushes the given object to the back of the queue.
+         * Constructs an empty queue with no capacity limit other than the one imposed by the storage policy.
+         */
+        Queue() : m_capacity(detail::storage_capacity<StoragePolicy>::value) {}
+
+        /**
+         * Constructs an empty queue that holds at most the given number of objects.
+         * @param[in] capacity The maximum number of objects the queue can hold. It is lowered to the capacity of the
+         * storage policy if that is smaller. A capacity of zero throws @c std::invalid_argument, since nothing could
+         * ever be pushed and every blocking push would wait forever.
+         */
+        explicit Queue(std::size_t capacity)
+            : m_capacity(
+                  std::min(capacity, static_cast<std::size_t>(detail::storage_capacity<StoragePolicy>::value))) {
+            if (capacity == 0) {
+                throw std::invalid_argument("mpmcplusplus::Queue capacity must be greater than zero");
+            }
+        }
+
+        /**
+         * Returns the maximum number of objects the queue can hold.
+         * @return The capacity of the queue, or the largest value of @c std::size_t if it is unbounded.
+         */
+        std::size_t capacity() const { return m_capacity; }
+
+        /**
+         * Pushes the given object to the back of the queue. This function will return immediately if the queue is
+         * full.
          * @param[in] data The const lvalue reference to be pushed to the queue.
          * @return true if an object was successfully pushed to the queue, otherwise false.
          */
         bool push(const T& data) {
-            std::unique_lock<std::mutex> lock(m_mutex);
+            std::unique_lock<LockPolicy> lock(m_mutex);
             if (!lock) {
                 return false;
             }
+            if (is_full()) {
+                return false;
+            }
             m_backing_queue.push(data);
-            lock.unlock();
-            m_condition_variable.notify_one();
+            notify_pushed(lock);
             return true;
         };
 
         /**
-         * Pushes the given object to the back of the queue.
+         * Pushes the given object to the back of the queue. This function will return immediately if the queue is
+         * full.
          * @param[in] data The rvalue reference to be pushed to the queue.
          * @return true if an object was successfully pushed to the queue, otherwise false
          */
         bool push(T&& data) {
-            std::unique_lock<std::mutex> lock(m_mutex);
+            std::unique_lock<LockPolicy> lock(m_mutex);
             if (!lock) {
                 return false;
             }
+            if (is_full()) {
+                return false;
+            }
             m_backing_queue.push(std::move(data));
-            lock.unlock();
-            m_condition_variable.notify_one();
+            notify_pushed(lock);
             return true;
         };
 
         /**
-         * Pushes a new object to the back of the queue. The object is constructed in-place.
+         * Pushes a new object to the back of the queue. The object is constructed in-place. This function will return
+         * immediately if the queue is full.
          * @param[in] args The arguments to forward to the constructor of the object.
          * @return true if an object was successfully emplaced in the queue, otherwise false
          */
         template <typename... Args>
         bool emplace(Args&&... args) {
-            std::unique_lock<std::mutex> lock(m_mutex);
+            std::unique_lock<LockPolicy> lock(m_mutex);
             if (!lock) {
                 return false;
             }
+            if (is_full()) {
+                return false;
+            }
             m_backing_queue.emplace(std::forward<Args>(args)...);
-            lock.unlock();
-            m_condition_variable.notify_one();
+            notify_pushed(lock);
             return true;
         }
 
+        /**
+         * Pushes the given object to the back of the queue. This function will wait indefinitely for an object to be
+         * popped from the queue if the queue is full.
+         * @param[in] data The const lvalue reference to be pushed to the queue.
+         * @return true if an object was successfully pushed to the queue, otherwise false.
+         */
+        bool wait_and_push(const T& data) { return wait_for_space_and_emplace(data); }
+
+        /**
+         * Pushes the given object to the back of the queue. This function will wait indefinitely for an object to be
+         * popped from the queue if the queue is full.
+         * @param[in] data The rvalue reference to be pushed to the queue.
+         * @return true if an object was successfully pushed to the queue, otherwise false.
+         */
+        bool wait_and_push(T&& data) { return wait_for_space_and_emplace(std::move(data)); }
+
+        /**
+         * Pushes the given object to the back of the queue. This function will wait for as long as the specified
+         * timeout for an object to be popped from the queue if the queue is full.
+         * @param[in] data The const lvalue reference to be pushed to the queue.
+         * @param[in] timeout A reference to a @c std::chrono::duration of how long this function should wait before
+         * returning.
+         * @return true if an object was successfully pushed to the queue, otherwise false.
+         */
+        template <typename Rep, typename Period>
+        bool wait_and_push(const T& data, const std::chrono::duration<Rep, Period>& timeout) {
+            return wait_for_space_and_emplace_for(timeout, data);
+        }
+
+        /**
+         * Pushes the given object to the back of the queue. This function will wait for as long as the specified
+         * timeout for an object to be popped from the queue if the queue is full.
+         * @param[in] data The rvalue reference to be pushed to the queue. It is left untouched if the function times
+         * out.
+         * @param[in] timeout A reference to a @c std::chrono::duration of how long this function should wait before
+         * returning.
+         * @return true if an object was successfully pushed to the queue, otherwise false.
+         */
+        template <typename Rep, typename Period>
+        bool wait_and_push(T&& data, const std::chrono::duration<Rep, Period>& timeout) {
+            return wait_for_space_and_emplace_for(timeout, std::move(data));
+        }
+
+        /**
+         * Pushes a new object to the back of the queue. The object is constructed in-place. This function will wait
+         * indefinitely for an object to be popped from the queue if the queue is full.
+         * @param[in] args The arguments to forward to the constructor of the object.
+         * @return true if an object was successfully emplaced in the queue, otherwise false.
+         */
+        template <typename... Args>
+        bool wait_and_emplace(Args&&... args) {
+            return wait_for_space_and_emplace(std::forward<Args>(args)...);
+        }
+
+        /**
+         * Pushes a new object to the back of the queue. The object is constructed in-place. This function will wait
+         * for as long as the specified timeout for an object to be popped from the queue if the queue is full. The
+         * timeout comes first because the constructor arguments are variadic.
+         * @param[in] timeout A reference to a @c std::chrono::duration of how long this function should wait before
+         * returning.
+         * @param[in] args The arguments to forward to the constructor of the object. They are left untouched if the
+         * function times out.
+         * @return true if an object was successfully emplaced in the queue, otherwise false.
+         */
+        template <typename Rep, typename Period, typename... Args>
+        bool wait_and_emplace_for(const std::chrono::duration<Rep, Period>& timeout, Args&&... args) {
+            return wait_for_space_and_emplace_for(timeout, std::forward<Args>(args)...);
+        }
+
         /**
          * Pops an object from the front of the queue without blocking. This function will return immediately if the
          * queue is empty.
@@ -96,7 +339,7 @@ namespace mpmcplusplus {
          * @return true if an object was popped from the front of the queue, otherwise false.
          */
         bool pop(T& data) {
-            std::unique_lock<std::mutex> lock(m_mutex);
+            std::unique_lock<LockPolicy> lock(m_mutex);
             if (!lock) {
                 return false;
             }
@@ -105,6 +348,8 @@ namespace mpmcplusplus {
             }
             data = std::move(m_backing_queue.front());
             m_backing_queue.pop();
+            lock.unlock();
+            notify_not_full();
             return true;
         };
 
@@ -115,7 +360,7 @@ namespace mpmcplusplus {
          * @return true if an object was popped from the front of the queue, otherwise false.
          */
         bool wait_and_pop(T& data) {
-            std::unique_lock<std::mutex> lock(m_mutex);
+            std::unique_lock<LockPolicy> lock(m_mutex);
             if (!lock) {
                 return false;
             }
@@ -124,6 +369,8 @@ namespace mpmcplusplus {
             }
             data = std::move(m_backing_queue.front());
             m_backing_queue.pop();
+            lock.unlock();
+            notify_not_full();
             return true;
         };
 
@@ -137,7 +384,7 @@ namespace mpmcplusplus {
          */
         template <typename Rep, typename Period>
         bool wait_and_pop(T& data, const std::chrono::duration<Rep, Period>& timeout) {
-            std::unique_lock<std::mutex> lock(m_mutex);
+            std::unique_lock<LockPolicy> lock(m_mutex);
             if (!lock) {
                 return false;
             }
@@ -149,9 +396,217 @@ namespace mpmcplusplus {
             }
             data = std::move(m_backing_queue.front());
             m_backing_queue.pop();
+            lock.unlock();
+            notify_not_full();
+            return true;
+        }
+
+        /**
+         * Pushes copies of the objects in the given range to the back of the queue under a single lock, then wakes up
+         * to one waiting consumer per object pushed. Objects are moved instead if the range is made of
+         * @c std::move_iterator. This function will return immediately once the queue is full, leaving the rest of
+         * the range unpushed.
+         * @param[in] first The beginning of the range of objects to push.
+         * @param[in] last The end of the range of objects to push.
+         * @return The number of objects pushed, counted from @p first.
+         */
+        template <typename InputIt>
+        std::size_t push_bulk(InputIt first, InputIt last) {
+            static_assert(std::is_convertible<typename std::iterator_traits<InputIt>::reference, T>::value,
+                          "the elements of the range must be implicitly convertible to T");
+            return emplace_bulk(first, last);
+        }
+
+        /**
+         * Pushes a new object to the back of the queue for each element of the given range under a single lock, then
+         * wakes up to one waiting consumer per object pushed. Each object is constructed in-place from an element of
+         * the range. This function will return immediately once the queue is full, leaving the rest of the range
+         * unused.
+         * @param[in] first The beginning of the range of constructor arguments.
+         * @param[in] last The end of the range of constructor arguments.
+         * @return The number of objects emplaced, counted from @p first.
+         */
+        template <typename InputIt>
+        std::size_t emplace_bulk(InputIt first, InputIt last) {
+            std::unique_lock<LockPolicy> lock(m_mutex);
+            if (!lock) {
+                return 0;
+            }
+            BulkPushGuard guard(*this, lock);
+            for (; first != last && !is_full(); ++first) {
+                m_backing_queue.emplace(*first);
+                ++guard.count;
+            }
+            return guard.count;
+        }
+
+        /**
+         * Pops up to the given number of objects from the front of the queue under a single lock without blocking.
+         * This function will return immediately if the queue is empty.
+         * @param[out] out The output iterator the popped objects are moved to, in the order they were pushed.
+         * @param[in] max The maximum number of objects to pop.
+         * @return The number of objects popped.
+         */
+        template <typename OutputIt>
+        std::size_t pop_bulk(OutputIt out, std::size_t max) {
+            std::unique_lock<LockPolicy> lock(m_mutex);
+            if (!lock) {
+                return 0;
+            }
+            const std::size_t count = pop_front(out, max);
+            lock.unlock();
+            notify_not_full(count);
+            return count;
+        }
+
+        /**
+         * Pops up to the given number of objects from the front of the queue under a single lock. This function will
+         * wait indefinitely for an object to be pushed to the queue if the queue is empty, and then pops whatever is
+         * there without waiting for more.
+         * @param[out] out The output iterator the popped objects are moved to, in the order they were pushed.
+         * @param[in] max The maximum number of objects to pop. Must not be zero.
+         * @return The number of objects popped.
+         */
+        template <typename OutputIt>
+        std::size_t wait_and_pop_bulk(OutputIt out, std::size_t max) {
+            std::unique_lock<LockPolicy> lock(m_mutex);
+            if (!lock) {
+                return 0;
+            }
+            while (m_backing_queue.empty()) {
+                m_condition_variable.wait(lock);
+            }
+            const std::size_t count = pop_front(out, max);
+            lock.unlock();
+            notify_not_full(count);
+            return count;
+        }
+
+        /**
+         * Pops up to the given number of objects from the front of the queue under a single lock. This function will
+         * wait for as long as the specified timeout for an object to be pushed to the queue if the queue is empty, and
+         * then pops whatever is there without waiting for more.
+         * @param[out] out The output iterator the popped objects are moved to, in the order they were pushed.
+         * @param[in] max The maximum number of objects to pop. Must not be zero.
+         * @param[in] timeout A reference to a @c std::chrono::duration of how long this function should wait before
+         * returning.
+         * @return The number of objects popped, which is zero if the function timed out.
+         */
+        template <typename OutputIt, typename Rep, typename Period>
+        std::size_t wait_and_pop_bulk(OutputIt out,
+                                      std::size_t max,
+                                      const std::chrono::duration<Rep, Period>& timeout) {
+            std::unique_lock<LockPolicy> lock(m_mutex);
+            if (!lock) {
+                return 0;
+            }
+            while (m_backing_queue.empty()) {
+                std::cv_status result = m_condition_variable.wait_for(lock, timeout);
+                if (result == std::cv_status::timeout) {
+                    return 0;
+                }
+            }
+            const std::size_t count = pop_front(out, max);
+            lock.unlock();
+            notify_not_full(count);
+            return count;
+        }
+
+        /**
+         * Takes every object in the queue at once by swapping the queue's storage with the given container under a
+         * single lock, which takes constant time no matter how many objects are queued. Passing the same container
+         * back once its objects have been processed and it is empty again lets the queue reuse its memory. This
+         * function will return immediately if the queue is empty, leaving the container untouched.
+         * @param[in,out] container An empty container that receives the objects of the queue in the order they were
+         * pushed.
+         * @return true if any objects were taken from the queue, otherwise false, including when the container was
+         * not empty.
+         */
+        bool drain(StoragePolicy& container) {
+            std::unique_lock<LockPolicy> lock(m_mutex);
+            if (!lock) {
+                return false;
+            }
+            if (!container.empty() || m_backing_queue.empty()) {
+                return false;
+            }
+            m_backing_queue.swap(container);
+            lock.unlock();
+            notify_not_full(container.size());
+            return true;
+        }
+
+        /**
+         * Takes every object in the queue at once by swapping the queue's storage with the given container under a
+         * single lock. This function will wait indefinitely for an object to be pushed to the queue if the queue is
+         * empty.
+         * @param[in,out] container An empty container that receives the objects of the queue in the order they were
+         * pushed.
+         * @return true if any objects were taken from the queue, otherwise false if the container was not empty.
+         */
+        bool wait_and_drain(StoragePolicy& container) {
+            if (!container.empty()) {
+                return false;
+            }
+            std::unique_lock<LockPolicy> lock(m_mutex);
+            if (!lock) {
+                return false;
+            }
+            while (m_backing_queue.empty()) {
+                m_condition_variable.wait(lock);
+            }
+            m_backing_queue.swap(container);
+            lock.unlock();
+            notify_not_full(container.size());
+            return true;
+        }
+
+        /**
+         * Takes every object in the queue at once by swapping the queue's storage with the given container under a
+         * single lock. This function will wait for as long as the specified timeout for an object to be pushed to the
+         * queue if the queue is empty.
+         * @param[in,out] container An empty container that receives the objects of the queue in the order they were
+         * pushed.
+         * @param[in] timeout A reference to a @c std::chrono::duration of how long this function should wait before
+         * returning.
+         * @return true if any objects were taken from the queue, otherwise false, including when the container was
+         * not empty.
+         */
+        template <typename Rep, typename Period>
+        bool wait_and_drain(StoragePolicy& container, const std::chrono::duration<Rep, Period>& timeout) {
+            if (!container.empty()) {
+                return false;
+            }
+            std::unique_lock<LockPolicy> lock(m_mutex);
+            if (!lock) {
+                return false;
+            }
+            while (m_backing_queue.empty()) {
+                std::cv_status result = m_condition_variable.wait_for(lock, timeout);
+                if (result == std::cv_status::timeout) {
+                    return false;
+                }
+            }
+            m_backing_queue.swap(container);
+            lock.unlock();
+            notify_not_full(container.size());
             return true;
         }
     };
+
+    /**
+     * A Queue with a compile-time capacity whose objects are stored inline in the queue object itself, so pushing and
+     * popping never allocate. The whole queue can be placed in pre-allocated memory.
+     * @tparam T The type of object the queue will be storing.
+     * @tparam N The number of objects the queue can hold. Must be a power of two.
+     * @tparam LockPolicy The lock guarding the storage.
+     * @tparam WaitPolicy The way blocked threads wait.
+     */
+    template <typename T,
+              std::size_t N,
+              typename LockPolicy = std::mutex,
+              typename WaitPolicy = ConditionVariableWait>
+    using FixedQueue = Queue<T, InlineRingBuffer<T, N>, LockPolicy, WaitPolicy>;
 }
 
 #endif
@@ -0,0 +1,181 @@
+/*
+ * multi_queue.h - Relaxed FIFO Multi Producer Multi Consumer queue implementation
+ * Copyright (C) 2021 James Triantafylos
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MPMCPLUSPLUS_MULTI_QUEUE_H
+#define MPMCPLUSPLUS_MULTI_QUEUE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <utility>
+
+#include "mpmcplusplus/detail.h"
+
+namespace mpmcplusplus {
+    /**
+     * A relaxed FIFO queue made of many independently locked sub-queues.
+     *
+     * Every object is stamped with the time it was pushed, and a pop compares the fronts of two random sub-queues and
+     * takes the one with the older stamp. Objects therefore come out roughly oldest first: the expected distance from
+     * true FIFO order is bounded by the number of sub-queues.
+     * @tparam T The type of object the queue will be storing.
+     */
+    template <typename T>
+    class MultiQueue {
+      private:
+        static constexpr std::uint64_t EMPTY = std::numeric_limits<std::uint64_t>::max();
+
+        struct SubQueue {
+            std::mutex mutex;
+            std::queue<std::pair<std::uint64_t, T>> backing_queue;
+            std::uint64_t last_stamp;
+            std::atomic<std::uint64_t> front_stamp;
+            char pad[detail::CACHE_LINE_SIZE];
+
+            SubQueue() : last_stamp(0), front_stamp(EMPTY) {}
+
+            bool has_objects() const { return front_stamp.load(std::memory_order_relaxed) != EMPTY; }
+
+            bool empty() const { return backing_queue.empty(); }
+
+            void pop(T& data) {
+                data = std::move(backing_queue.front().second);
+                backing_queue.pop();
+                front_stamp.store(backing_queue.empty() ? EMPTY : backing_queue.front().first,
+                                  std::memory_order_relaxed);
+            }
+        };
+
+        detail::SubQueueSet<SubQueue> m_queues;
+        detail::EventCount m_event_count;
+
+        template <typename... Args>
+        bool emplace_random(Args&&... args) {
+            std::unique_lock<std::mutex> lock;
+            SubQueue& queue = m_queues.lock_random(lock);
+            // Stamps are taken under the lock and never go backwards, so every sub-queue stays sorted by stamp.
+            std::uint64_t stamp =
+                static_cast<std::uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+            if (stamp < queue.last_stamp) {
+                stamp = queue.last_stamp;
+            }
+            queue.last_stamp = stamp;
+            queue.backing_queue.emplace(std::piecewise_construct, std::forward_as_tuple(stamp),
+                                        std::forward_as_tuple(std::forward<Args>(args)...));
+            if (queue.backing_queue.size() == 1) {
+                queue.front_stamp.store(stamp, std::memory_order_relaxed);
+            }
+            lock.unlock();
+            m_event_count.notify_one();
+            return true;
+        }
+
+        bool try_pop(T& data) {
+            return m_queues.try_pop(data, [](const SubQueue& first, const SubQueue& second) {
+                return first.backing_queue.front().first <= second.backing_queue.front().first;
+            });
+        }
+
+      public:
+        /**
+         * Constructs an empty queue.
+         * @param[in] queues_per_thread The number of sub-queues per thread. Higher values lower contention at the cost
+         * of a looser FIFO order.
+         * @param[in] thread_count The number of threads expected to use the queue. Defaults to the number of hardware
+         * threads.
+         */
+        explicit MultiQueue(std::size_t queues_per_thread = 2,
+                            std::size_t thread_count = std::thread::hardware_concurrency())
+            : m_queues(queues_per_thread * thread_count) {}
+
+        MultiQueue(const MultiQueue&) = delete;
+        MultiQueue& operator=(const MultiQueue&) = delete;
+
+        /**
+         * Returns the number of sub-queues the queue spreads its objects over.
+         * @return The sub-queue count of the queue.
+         */
+        std::size_t queue_count() const { return m_queues.count(); }
+
+        /**
+         * Pushes the given object to the back of a random sub-queue.
+         * @param[in] data The const lvalue reference to be pushed to the queue.
+         * @return true if an object was successfully pushed to the queue, otherwise false.
+         */
+        bool push(const T& data) { return emplace_random(data); }
+
+        /**
+         * Pushes the given object to the back of a random sub-queue.
+         * @param[in] data The rvalue reference to be pushed to the queue.
+         * @return true if an object was successfully pushed to the queue, otherwise false.
+         */
+        bool push(T&& data) { return emplace_random(std::move(data)); }
+
+        /**
+         * Pushes a new object to the back of a random sub-queue. The object is constructed in-place.
+         * @param[in] args The arguments to forward to the constructor of the object.
+         * @return true if an object was successfully emplaced in the queue, otherwise false.
+         */
+        template <typename... Args>
+        bool emplace(Args&&... args) {
+            return emplace_random(std::forward<Args>(args)...);
+        }
+
+        /**
+         * Pops one of the oldest objects from the queue without blocking. This function will return immediately if the
+         * queue is empty.
+         * @param[out] data A reference to where the popped object will be stored.
+         * @return true if an object was popped from the queue, otherwise false.
+         */
+        bool pop(T& data) { return try_pop(data); }
+
+        /**
+         * Pops one of the oldest objects from the queue. This function will wait indefinitely for an object to be
+         * pushed to the queue if the queue is empty.
+         * @param[out] data A reference to where the popped object will be stored.
+         * @return true if an object was popped from the queue, otherwise false.
+         */
+        bool wait_and_pop(T& data) {
+            detail::wait_for_pop(m_event_count, [this, &data]() { return try_pop(data); });
+            return true;
+        }
+
+        /**
+         * Pops one of the oldest objects from the queue. This function will wait for as long as the specified timeout
+         * for an object to be pushed to the queue if the queue is empty.
+         * @param[out] data A reference to where the popped object will be stored.
+         * @param[in] timeout A reference to a @c std::chrono::duration of how long this function should wait before
+         * returning.
+         * @return true if an object was popped from the queue, otherwise false.
+         */
+        template <typename Rep, typename Period>
+        bool wait_and_pop(T& data, const std::chrono::duration<Rep, Period>& timeout) {
+            return detail::wait_for_pop(m_event_count, [this, &data]() { return try_pop(data); }, timeout);
+        }
+    };
+
+    template <typename T>
+    constexpr std::uint64_t MultiQueue<T>::EMPTY;
+}
+
+#endif
@@ -0,0 +1,413 @@
+/*
+ * policies.h - Storage, locking and waiting policies for mpmcplusplus::Queue
+ * Copyright (C) 2021 James Triantafylos
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MPMCPLUSPLUS_POLICIES_H
+#define MPMCPLUSPLUS_POLICIES_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+#if defined(__linux__)
+#include <cerrno>
+#include <climits>
+#include <ctime>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "mpmcplusplus/detail.h"
+
+namespace mpmcplusplus {
+    /**
+     * A growable ring buffer that can be used as the storage policy of a Queue in place of @c std::queue.
+     *
+     * Objects live in one contiguous power-of-two sized array that doubles when it fills up and is never shrunk, so
+     * once a queue has reached its working size pushing and popping no longer allocate, unlike the chunks of the
+     * @c std::deque behind @c std::queue.
+     * @tparam T The type of object the buffer will be storing.
+     */
+    template <typename T>
+    class RingBuffer {
+      private:
+        typedef typename std::aligned_storage<sizeof(T), alignof(T)>::type Slot;
+
+        std::unique_ptr<Slot[]> m_slots;
+        std::size_t m_mask;
+        std::size_t m_head;
+        std::size_t m_size;
+
+        T* slot(std::size_t index) { return reinterpret_cast<T*>(&m_slots[index & m_mask]); }
+
+        void grow() {
+            const std::size_t capacity = (m_mask + 1) * 2;
+            std::unique_ptr<Slot[]> slots(new Slot[capacity]);
+            for (std::size_t i = 0; i < m_size; ++i) {
+                T* object = slot(m_head + i);
+                new (&slots[i]) T(std::move(*object));
+                object->~T();
+            }
+            m_slots.swap(slots);
+            m_mask = capacity - 1;
+            m_head = 0;
+        }
+
+      public:
+        /**
+         * Constructs an empty buffer.
+         * @param[in] capacity The number of objects the buffer can hold before it first has to grow. It is rounded up
+         * to the next power of two.
+         */
+        explicit RingBuffer(std::size_t capacity = 16)
+            : m_slots(new Slot[detail::round_up_to_power_of_two(capacity)]),
+              m_mask(detail::round_up_to_power_of_two(capacity) - 1),
+              m_head(0),
+              m_size(0) {}
+
+        RingBuffer(const RingBuffer&) = delete;
+        RingBuffer& operator=(const RingBuffer&) = delete;
+
+        ~RingBuffer() {
+            while (!empty()) {
+                pop();
+            }
+        }
+
+        /**
+         * Returns whether the buffer holds no objects.
+         * @return true if the buffer is empty, otherwise false.
+         */
+        bool empty() const { return m_size == 0; }
+
+        /**
+         * Returns the number of objects in the buffer.
+         * @return The size of the buffer.
+         */
+        std::size_t size() const { return m_size; }
+
+        /**
+         * Returns the object at the front of the buffer. The buffer must not be empty.
+         * @return A reference to the oldest object in the buffer.
+         */
+        T& front() { return *slot(m_head); }
+
+        /**
+         * Pushes the given object to the back of the buffer.
+         * @param[in] data The const lvalue reference to be pushed to the buffer.
+         */
+        void push(const T& data) { emplace(data); }
+
+        /**
+         * Pushes the given object to the back of the buffer.
+         * @param[in] data The rvalue reference to be pushed to the buffer.
+         */
+        void push(T&& data) { emplace(std::move(data)); }
+
+        /**
+         * Pushes a new object to the back of the buffer. The object is constructed in-place.
+         * @param[in] args The arguments to forward to the constructor of the object.
+         */
+        template <typename... Args>
+        void emplace(Args&&... args) {
+            if (m_size > m_mask) {
+                grow();
+            }
+            new (slot(m_head + m_size)) T(std::forward<Args>(args)...);
+            ++m_size;
+        }
+
+        /**
+         * Destroys the object at the front of the buffer. The buffer must not be empty.
+         */
+        void pop() {
+            slot(m_head)->~T();
+            ++m_head;
+            --m_size;
+        }
+
+        /**
+         * Exchanges the contents of this buffer with another one.
+         * @param[in,out] other The buffer to exchange contents with.
+         */
+        void swap(RingBuffer& other) {
+            m_slots.swap(other.m_slots);
+            std::swap(m_mask, other.m_mask);
+            std::swap(m_head, other.m_head);
+            std::swap(m_size, other.m_size);
+        }
+    };
+
+    /**
+     * A fixed-capacity ring buffer stored inline that can be used as the storage policy of a Queue.
+     *
+     * The slots are a plain array inside the object, so a queue using it never touches the heap and can be placed in
+     * pre-faulted or otherwise pre-allocated memory. The index wraps with a mask, which is why the capacity must be a
+     * power of two. A Queue using this storage is bounded to the capacity of the buffer.
+     * @tparam T The type of object the buffer will be storing.
+     * @tparam N The number of objects the buffer can hold. Must be a power of two.
+     */
+    template <typename T, std::size_t N>
+    class InlineRingBuffer {
+        static_assert(N > 0 && (N & (N - 1)) == 0, "N must be a power of two");
+
+      public:
+        /**
+         * The number of objects the buffer can hold.
+         */
+        static constexpr std::size_t capacity = N;
+
+      private:
+        std::array<typename std::aligned_storage<sizeof(T), alignof(T)>::type, N> m_slots;
+        std::size_t m_head;
+        std::size_t m_size;
+
+        T* slot(std::size_t index) { return reinterpret_cast<T*>(&m_slots[index & (N - 1)]); }
+
+      public:
+        /**
+         * Constructs an empty buffer.
+         */
+        InlineRingBuffer() : m_head(0), m_size(0) {}
+
+        InlineRingBuffer(const InlineRingBuffer&) = delete;
+        InlineRingBuffer& operator=(const InlineRingBuffer&) = delete;
+
+        ~InlineRingBuffer() {
+            while (!empty()) {
+                pop();
+            }
+        }
+
+        /**
+         * Returns whether the buffer holds no objects.
+         * @return true if the buffer is empty, otherwise false.
+         */
+        bool empty() const { return m_size == 0; }
+
+        /**
+         * Returns the number of objects in the buffer.
+         * @return The size of the buffer.
+         */
+        std::size_t size() const { return m_size; }
+
+        /**
+         * Returns the object at the front of the buffer. The buffer must not be empty.
+         * @return A reference to the oldest object in the buffer.
+         */
+        T& front() { return *slot(m_head); }
+
+        /**
+         * Pushes the given object to the back of the buffer. The buffer must not be full.
+         * @param[in] data The const lvalue reference to be pushed to the buffer.
+         */
+        void push(const T& data) { emplace(data); }
+
+        /**
+         * Pushes the given object to the back of the buffer. The buffer must not be full.
+         * @param[in] data The rvalue reference to be pushed to the buffer.
+         */
+        void push(T&& data) { emplace(std::move(data)); }
+
+        /**
+         * Pushes a new object to the back of the buffer. The object is constructed in-place. The buffer must not be
+         * full.
+         * @param[in] args The arguments to forward to the constructor of the object.
+         */
+        template <typename... Args>
+        void emplace(Args&&... args) {
+            new (slot(m_head + m_size)) T(std::forward<Args>(args)...);
+            ++m_size;
+        }
+
+        /**
+         * Destroys the object at the front of the buffer. The buffer must not be empty.
+         */
+        void pop() {
+            slot(m_head)->~T();
+            ++m_head;
+            --m_size;
+        }
+    };
+
+    template <typename T, std::size_t N>
+    constexpr std::size_t InlineRingBuffer<T, N>::capacity;
+
+    /**
+     * A test-and-test-and-set spinlock that can be used as the lock policy of a Queue in place of @c std::mutex.
+     *
+     * It never sleeps in the kernel, which makes it a good fit for queues whose critical sections are a handful of
+     * instructions and whose threads each have a core to themselves. It yields the processor while the lock is held
+     * so that oversubscribed threads still make progress.
+     */
+    class SpinLock {
+      private:
+        std::atomic<bool> m_locked;
+
+      public:
+        SpinLock() : m_locked(false) {}
+
+        SpinLock(const SpinLock&) = delete;
+        SpinLock& operator=(const SpinLock&) = delete;
+
+        /**
+         * Acquires the lock, spinning until it is available.
+         */
+        void lock() {
+            while (m_locked.exchange(true, std::memory_order_acquire)) {
+                while (m_locked.load(std::memory_order_relaxed)) {
+                    std::this_thread::yield();
+                }
+            }
+        }
+
+        /**
+         * Tries to acquire the lock without spinning.
+         * @return true if the lock was acquired, otherwise false.
+         */
+        bool try_lock() {
+            return !m_locked.load(std::memory_order_relaxed) && !m_locked.exchange(true, std::memory_order_acquire);
+        }
+
+        /**
+         * Releases the lock.
+         */
+        void unlock() { m_locked.store(false, std::memory_order_release); }
+    };
+
+    /**
+     * The default wait policy of a Queue. Blocked threads wait on a @c std::condition_variable, or on a
+     * @c std::condition_variable_any if the lock policy is not @c std::mutex.
+     */
+    struct ConditionVariableWait {
+        /**
+         * The waiter type used for the given lock policy.
+         * @tparam Lock The lock policy of the queue.
+         */
+        template <typename Lock>
+        using waiter = typename std::conditional<std::is_same<Lock, std::mutex>::value,
+                                                 std::condition_variable,
+                                                 std::condition_variable_any>::type;
+    };
+
+#if defined(__linux__)
+    /**
+     * A wait policy that parks blocked threads directly on a Linux futex.
+     *
+     * Notifying only makes a system call when some thread is actually asleep, and a woken thread does not have to
+     * reacquire an internal condition variable mutex before it can go after the queue's own lock.
+     */
+    struct FutexWait {
+        /**
+         * The waiter type used for the given lock policy.
+         * @tparam Lock The lock policy of the queue.
+         */
+        template <typename Lock>
+        class waiter {
+          private:
+            std::atomic<std::uint32_t> m_epoch;
+            std::atomic<std::uint32_t> m_waiters;
+
+            long futex(int operation, std::uint32_t value, const struct timespec* timeout) {
+                return syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&m_epoch), operation, value, timeout,
+                               nullptr, 0);
+            }
+
+          public:
+            waiter() : m_epoch(0), m_waiters(0) {}
+
+            waiter(const waiter&) = delete;
+            waiter& operator=(const waiter&) = delete;
+
+            /**
+             * Releases the lock, waits for a notification and reacquires the lock.
+             * @param[in,out] lock The held lock protecting the waited-for condition.
+             */
+            void wait(std::unique_lock<Lock>& lock) {
+                const std::uint32_t epoch = m_epoch.load(std::memory_order_seq_cst);
+                m_waiters.fetch_add(1, std::memory_order_seq_cst);
+                lock.unlock();
+                futex(FUTEX_WAIT_PRIVATE, epoch, nullptr);
+                m_waiters.fetch_sub(1, std::memory_order_seq_cst);
+                lock.lock();
+            }
+
+            /**
+             * Releases the lock, waits for a notification or for the timeout to elapse and reacquires the lock.
+             * @param[in,out] lock The held lock protecting the waited-for condition.
+             * @param[in] timeout How long to wait for.
+             * @return @c std::cv_status::timeout if the timeout elapsed, otherwise @c std::cv_status::no_timeout.
+             */
+            template <typename Rep, typename Period>
+            std::cv_status wait_for(std::unique_lock<Lock>& lock, const std::chrono::duration<Rep, Period>& timeout) {
+                // Casting a timeout of centuries straight to nanoseconds would overflow, so clamp it first.
+                typedef std::chrono::duration<double, std::nano> approximate;
+                std::chrono::nanoseconds nanoseconds = std::chrono::nanoseconds::max();
+                if (approximate(timeout) < approximate(nanoseconds)) {
+                    nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(timeout);
+                }
+                if (nanoseconds < std::chrono::nanoseconds::zero()) {
+                    nanoseconds = std::chrono::nanoseconds::zero();
+                }
+                struct timespec relative;
+                relative.tv_sec = static_cast<std::time_t>(nanoseconds.count() / 1000000000);
+                relative.tv_nsec = static_cast<long>(nanoseconds.count() % 1000000000);
+                const std::uint32_t epoch = m_epoch.load(std::memory_order_seq_cst);
+                m_waiters.fetch_add(1, std::memory_order_seq_cst);
+                lock.unlock();
+                const long result = futex(FUTEX_WAIT_PRIVATE, epoch, &relative);
+                const bool timed_out = result != 0 && errno == ETIMEDOUT;
+                m_waiters.fetch_sub(1, std::memory_order_seq_cst);
+                lock.lock();
+                return timed_out ? std::cv_status::timeout : std::cv_status::no_timeout;
+            }
+
+            /**
+             * Wakes up one waiting thread, if any.
+             */
+            void notify_one() {
+                m_epoch.fetch_add(1, std::memory_order_seq_cst);
+                if (m_waiters.load(std::memory_order_seq_cst) != 0) {
+                    futex(FUTEX_WAKE_PRIVATE, 1, nullptr);
+                }
+            }
+
+            /**
+             * Wakes up every waiting thread, if any.
+             */
+            void notify_all() {
+                m_epoch.fetch_add(1, std::memory_order_seq_cst);
+                if (m_waiters.load(std::memory_order_seq_cst) != 0) {
+                    futex(FUTEX_WAKE_PRIVATE, INT_MAX, nullptr);
+                }
+            }
+        };
+    };
+#endif
+}
+
+#endif
@@ -0,0 +1,180 @@
+/*
+ * priority_lane_queue.h - Multi Producer Multi Consumer queue with fixed priority lanes
+ * Copyright (C) 2021 James Triantafylos
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MPMCPLUSPLUS_PRIORITY_LANE_QUEUE_H
+#define MPMCPLUSPLUS_PRIORITY_LANE_QUEUE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <queue>
+#include <utility>
+
+#include "mpmcplusplus/detail.h"
+
+namespace mpmcplusplus {
+    /**
+     * A queue with a fixed number of strict priority lanes, each of which is an independently locked FIFO.
+     *
+     * Lane 0 has the highest priority. A bitmap with one bit per lane records which lanes hold objects, with lane 0 in
+     * the most significant bit, so a pop finds the highest priority non-empty lane with a single count-leading-zeros
+     * and only locks that lane. Objects within a lane are popped in the order they were pushed. Consumers blocked in
+     * wait_and_pop are woken by a push to any lane.
+     * @tparam T The type of object the queue will be storing.
+     * @tparam Lanes The number of priority lanes. Must be between 1 and 64.
+     */
+    template <typename T, std::size_t Lanes>
+    class PriorityLaneQueue {
+        static_assert(Lanes > 0 && Lanes <= 64, "Lanes must be between 1 and 64");
+
+      private:
+        struct Lane {
+            std::mutex mutex;
+            std::queue<T> backing_queue;
+            char pad[detail::CACHE_LINE_SIZE];
+        };
+
+        Lane m_lanes[Lanes];
+        char m_pad_0[detail::CACHE_LINE_SIZE];
+        std::atomic<std::uint64_t> m_non_empty;
+        char m_pad_1[detail::CACHE_LINE_SIZE];
+        detail::EventCount m_event_count;
+
+        static std::uint64_t lane_bit(std::size_t lane) { return static_cast<std::uint64_t>(1) << (63 - lane); }
+
+        template <typename... Args>
+        bool emplace_back(std::size_t lane, Args&&... args) {
+            if (lane >= Lanes) {
+                return false;
+            }
+            std::unique_lock<std::mutex> lock(m_lanes[lane].mutex);
+            if (!lock) {
+                return false;
+            }
+            m_lanes[lane].backing_queue.emplace(std::forward<Args>(args)...);
+            if (m_lanes[lane].backing_queue.size() == 1) {
+                m_non_empty.fetch_or(lane_bit(lane), std::memory_order_release);
+            }
+            lock.unlock();
+            m_event_count.notify_one();
+            return true;
+        }
+
+        bool try_pop(T& data) {
+            for (;;) {
+                std::uint64_t non_empty = m_non_empty.load(std::memory_order_acquire);
+                if (non_empty == 0) {
+                    return false;
+                }
+                const std::size_t lane = detail::count_leading_zeros(non_empty);
+                std::lock_guard<std::mutex> lock(m_lanes[lane].mutex);
+                std::queue<T>& backing_queue = m_lanes[lane].backing_queue;
+                // The bit is only ever changed under the lane's lock, so an empty lane here was drained by another
+                // consumer that has already cleared it.
+                if (backing_queue.empty()) {
+                    continue;
+                }
+                data = std::move(backing_queue.front());
+                backing_queue.pop();
+                if (backing_queue.empty()) {
+                    m_non_empty.fetch_and(~lane_bit(lane), std::memory_order_relaxed);
+                }
+                return true;
+            }
+        }
+
+      public:
+        /**
+         * Constructs an empty queue.
+         */
+        PriorityLaneQueue() : m_non_empty(0) {}
+
+        PriorityLaneQueue(const PriorityLaneQueue&) = delete;
+        PriorityLaneQueue& operator=(const PriorityLaneQueue&) = delete;
+
+        /**
+         * Returns the number of priority lanes.
+         * @return The number of lanes of the queue.
+         */
+        std::size_t lane_count() const { return Lanes; }
+
+        /**
+         * Pushes the given object to the back of the given lane.
+         * @param[in] lane The lane to push to, where 0 is the highest priority.
+         * @param[in] data The const lvalue reference to be pushed to the queue.
+         * @return true if an object was successfully pushed to the queue, otherwise false if the lane does not exist.
+         */
+        bool push(std::size_t lane, const T& data) { return emplace_back(lane, data); }
+
+        /**
+         * Pushes the given object to the back of the given lane.
+         * @param[in] lane The lane to push to, where 0 is the highest priority.
+         * @param[in] data The rvalue reference to be pushed to the queue.
+         * @return true if an object was successfully pushed to the queue, otherwise false if the lane does not exist.
+         */
+        bool push(std::size_t lane, T&& data) { return emplace_back(lane, std::move(data)); }
+
+        /**
+         * Pushes a new object to the back of the given lane. The object is constructed in-place.
+         * @param[in] lane The lane to push to, where 0 is the highest priority.
+         * @param[in] args The arguments to forward to the constructor of the object.
+         * @return true if an object was successfully emplaced in the queue, otherwise false if the lane does not
+         * exist.
+         */
+        template <typename... Args>
+        bool emplace(std::size_t lane, Args&&... args) {
+            return emplace_back(lane, std::forward<Args>(args)...);
+        }
+
+        /**
+         * Pops the front object of the highest priority non-empty lane without blocking. This function will return
+         * immediately if every lane is empty.
+         * @param[out] data A reference to where the popped object will be stored.
+         * @return true if an object was popped from the queue, otherwise false.
+         */
+        bool pop(T& data) { return try_pop(data); }
+
+        /**
+         * Pops the front object of the highest priority non-empty lane. This function will wait indefinitely for an
+         * object to be pushed to any lane if every lane is empty.
+         * @param[out] data A reference to where the popped object will be stored.
+         * @return true if an object was popped from the queue, otherwise false.
+         */
+        bool wait_and_pop(T& data) {
+            detail::wait_for_pop(m_event_count, [this, &data]() { return try_pop(data); });
+            return true;
+        }
+
+        /**
+         * Pops the front object of the highest priority non-empty lane. This function will wait for as long as the
+         * specified timeout for an object to be pushed to any lane if every lane is empty.
+         * @param[out] data A reference to where the popped object will be stored.
+         * @param[in] timeout A reference to a @c std::chrono::duration of how long this function should wait before
+         * returning.
+         * @return true if an object was popped from the queue, otherwise false.
+         */
+        template <typename Rep, typename Period>
+        bool wait_and_pop(T& data, const std::chrono::duration<Rep, Period>& timeout) {
+            return detail::wait_for_pop(m_event_count, [this, &data]() { return try_pop(data); }, timeout);
+        }
+    };
+}
+
+#endif
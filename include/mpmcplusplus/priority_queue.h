@@ -0,0 +1,166 @@
+/*
+ * priority_queue.h - Relaxed concurrent priority queue implementation
+ * Copyright (C) 2021 James Triantafylos
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MPMCPLUSPLUS_PRIORITY_QUEUE_H
+#define MPMCPLUSPLUS_PRIORITY_QUEUE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "mpmcplusplus/detail.h"
+
+namespace mpmcplusplus {
+    /**
+     * A thread-safe priority queue that spreads its objects over several independently locked heaps.
+     *
+     * A pop compares the tops of two random heaps and takes the higher priority one, so it returns one of the highest
+     * priority objects rather than always the highest: the expected rank of the popped object is bounded by the
+     * number of heaps.
+     * @tparam T The type of object the queue will be storing.
+     * @tparam Compare The comparator ordering objects, with the same meaning as for @c std::priority_queue: by default
+     * the largest object has the highest priority.
+     */
+    template <typename T, typename Compare = std::less<T>>
+    class PriorityQueue {
+      private:
+        struct Heap {
+            std::mutex mutex;
+            std::priority_queue<T, std::vector<T>, Compare> backing_queue;
+            std::atomic<std::size_t> size;
+            char pad[detail::CACHE_LINE_SIZE];
+
+            explicit Heap(const Compare& compare) : backing_queue(compare), size(0) {}
+
+            bool has_objects() const { return size.load(std::memory_order_relaxed) != 0; }
+
+            bool empty() const { return backing_queue.empty(); }
+
+            void pop(T& data) {
+                // std::priority_queue only exposes its top as const, but the object is removed right after the move.
+                data = std::move(const_cast<T&>(backing_queue.top()));
+                backing_queue.pop();
+                size.store(backing_queue.size(), std::memory_order_relaxed);
+            }
+        };
+
+        detail::SubQueueSet<Heap> m_heaps;
+        Compare m_compare;
+        detail::EventCount m_event_count;
+
+        template <typename... Args>
+        bool emplace_random(Args&&... args) {
+            std::unique_lock<std::mutex> lock;
+            Heap& heap = m_heaps.lock_random(lock);
+            heap.backing_queue.emplace(std::forward<Args>(args)...);
+            heap.size.store(heap.backing_queue.size(), std::memory_order_relaxed);
+            lock.unlock();
+            m_event_count.notify_one();
+            return true;
+        }
+
+        bool try_pop(T& data) {
+            return m_heaps.try_pop(data, [this](const Heap& first, const Heap& second) {
+                return !m_compare(first.backing_queue.top(), second.backing_queue.top());
+            });
+        }
+
+      public:
+        /**
+         * Constructs an empty queue.
+         * @param[in] heap_count The number of heaps to spread objects over. Defaults to two per hardware thread.
+         * @param[in] compare The comparator to order objects with.
+         */
+        explicit PriorityQueue(std::size_t heap_count = 2 * std::thread::hardware_concurrency(),
+                               const Compare& compare = Compare())
+            : m_heaps(heap_count, compare), m_compare(compare) {}
+
+        PriorityQueue(const PriorityQueue&) = delete;
+        PriorityQueue& operator=(const PriorityQueue&) = delete;
+
+        /**
+         * Returns the number of heaps the queue spreads its objects over.
+         * @return The heap count of the queue.
+         */
+        std::size_t heap_count() const { return m_heaps.count(); }
+
+        /**
+         * Pushes the given object to the queue.
+         * @param[in] data The const lvalue reference to be pushed to the queue.
+         * @return true if an object was successfully pushed to the queue, otherwise false.
+         */
+        bool push(const T& data) { return emplace_random(data); }
+
+        /**
+         * Pushes the given object to the queue.
+         * @param[in] data The rvalue reference to be pushed to the queue.
+         * @return true if an object was successfully pushed to the queue, otherwise false.
+         */
+        bool push(T&& data) { return emplace_random(std::move(data)); }
+
+        /**
+         * Pushes a new object to the queue. The object is constructed in-place.
+         * @param[in] args The arguments to forward to the constructor of the object.
+         * @return true if an object was successfully emplaced in the queue, otherwise false.
+         */
+        template <typename... Args>
+        bool emplace(Args&&... args) {
+            return emplace_random(std::forward<Args>(args)...);
+        }
+
+        /**
+         * Pops one of the highest priority objects from the queue without blocking. This function will return
+         * immediately if the queue is empty.
+         * @param[out] data A reference to where the popped object will be stored.
+         * @return true if an object was popped from the queue, otherwise false.
+         */
+        bool pop(T& data) { return try_pop(data); }
+
+        /**
+         * Pops one of the highest priority objects from the queue. This function will wait indefinitely for an object
+         * to be pushed to the queue if the queue is empty.
+         * @param[out] data A reference to where the popped object will be stored.
+         * @return true if an object was popped from the queue, otherwise false.
+         */
+        bool wait_and_pop(T& data) {
+            detail::wait_for_pop(m_event_count, [this, &data]() { return try_pop(data); });
+            return true;
+        }
+
+        /**
+         * Pops one of the highest priority objects from the queue. This function will wait for as long as the
+         * specified timeout for an object to be pushed to the queue if the queue is empty.
+         * @param[out] data A reference to where the popped object will be stored.
+         * @param[in] timeout A reference to a @c std::chrono::duration of how long this function should wait before
+         * returning.
+         * @return true if an object was popped from the queue, otherwise false.
+         */
+        template <typename Rep, typename Period>
+        bool wait_and_pop(T& data, const std::chrono::duration<Rep, Period>& timeout) {
+            return detail::wait_for_pop(m_event_count, [this, &data]() { return try_pop(data); }, timeout);
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,216 @@
+/*
+ * ring_queue.h - Bounded lock-free Multi Producer Multi Consumer queue implementation
+ * Copyright (C) 2021 James Triantafylos
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MPMCPLUSPLUS_RING_QUEUE_H
+#define MPMCPLUSPLUS_RING_QUEUE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "mpmcplusplus/detail.h"
+
+namespace mpmcplusplus {
+    /**
+     * A fixed-capacity, lock-free queue backed by a ring buffer of sequence-numbered slots.
+     *
+     * Every slot carries a sequence number that tells producers and consumers whether it is free for the current lap
+     * of the ring. Claiming a slot is a single compare-and-swap on the head or tail index, so the uncontended path of
+     * push and pop is a handful of atomic operations. Consumers blocked in wait_and_pop are only woken through a
+     * mutex when they are actually asleep.
+     * @tparam T The type of object the queue will be storing.
+     */
+    template <typename T>
+    class RingQueue {
+      private:
+        struct Slot {
+            std::atomic<std::size_t> sequence;
+            bool hole;
+            typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+        };
+
+        char m_pad_0[detail::CACHE_LINE_SIZE];
+        std::atomic<std::size_t> m_tail;
+        char m_pad_1[detail::CACHE_LINE_SIZE];
+        std::atomic<std::size_t> m_head;
+        char m_pad_2[detail::CACHE_LINE_SIZE];
+        const std::size_t m_mask;
+        std::unique_ptr<Slot[]> m_slots;
+        detail::EventCount m_event_count;
+
+        template <typename... Args>
+        bool try_emplace(Args&&... args) {
+            std::size_t position = m_tail.load(std::memory_order_relaxed);
+            for (;;) {
+                Slot& slot = m_slots[position & m_mask];
+                std::size_t sequence = slot.sequence.load(std::memory_order_acquire);
+                std::ptrdiff_t difference = static_cast<std::ptrdiff_t>(sequence - position);
+                if (difference == 0) {
+                    if (m_tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                        try {
+                            new (&slot.storage) T(std::forward<Args>(args)...);
+                        } catch (...) {
+                            // The slot is already claimed, so publish it as a hole for consumers to skip rather than
+                            // leave them waiting on it forever.
+                            slot.hole = true;
+                            slot.sequence.store(position + 1, std::memory_order_release);
+                            throw;
+                        }
+                        slot.sequence.store(position + 1, std::memory_order_release);
+                        m_event_count.notify_one();
+                        return true;
+                    }
+                } else if (difference < 0) {
+                    return false;
+                } else {
+                    position = m_tail.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        bool try_pop(T& data) {
+            std::size_t position = m_head.load(std::memory_order_relaxed);
+            for (;;) {
+                Slot& slot = m_slots[position & m_mask];
+                std::size_t sequence = slot.sequence.load(std::memory_order_acquire);
+                std::ptrdiff_t difference = static_cast<std::ptrdiff_t>(sequence - (position + 1));
+                if (difference == 0) {
+                    if (m_head.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                        const bool hole = slot.hole;
+                        if (!hole) {
+                            T* object = reinterpret_cast<T*>(&slot.storage);
+                            data = std::move(*object);
+                            object->~T();
+                        }
+                        slot.hole = false;
+                        slot.sequence.store(position + m_mask + 1, std::memory_order_release);
+                        if (!hole) {
+                            return true;
+                        }
+                        position = m_head.load(std::memory_order_relaxed);
+                    }
+                } else if (difference < 0) {
+                    return false;
+                } else {
+                    position = m_head.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+      public:
+        /**
+         * Constructs an empty queue.
+         * @param[in] capacity The minimum number of objects the queue can hold. It is rounded up to the next power of
+         * two.
+         */
+        explicit RingQueue(std::size_t capacity)
+            : m_tail(0),
+              m_head(0),
+              m_mask(detail::round_up_to_power_of_two(capacity < 2 ? 2 : capacity) - 1),
+              m_slots(new Slot[m_mask + 1]) {
+            for (std::size_t i = 0; i <= m_mask; ++i) {
+                m_slots[i].sequence.store(i, std::memory_order_relaxed);
+                m_slots[i].hole = false;
+            }
+        }
+
+        RingQueue(const RingQueue&) = delete;
+        RingQueue& operator=(const RingQueue&) = delete;
+
+        ~RingQueue() {
+            std::size_t tail = m_tail.load(std::memory_order_relaxed);
+            for (std::size_t head = m_head.load(std::memory_order_relaxed); head != tail; ++head) {
+                Slot& slot = m_slots[head & m_mask];
+                if (!slot.hole) {
+                    reinterpret_cast<T*>(&slot.storage)->~T();
+                }
+            }
+        }
+
+        /**
+         * Returns the number of objects the queue can hold.
+         * @return The capacity of the queue.
+         */
+        std::size_t capacity() const { return m_mask + 1; }
+
+        /**
+         * Pushes the given object to the back of the queue. This function will return immediately if the queue is
+         * full.
+         * @param[in] data The const lvalue reference to be pushed to the queue.
+         * @return true if an object was successfully pushed to the queue, otherwise false.
+         */
+        bool push(const T& data) { return try_emplace(data); }
+
+        /**
+         * Pushes the given object to the back of the queue. This function will return immediately if the queue is
+         * full.
+         * @param[in] data The rvalue reference to be pushed to the queue.
+         * @return true if an object was successfully pushed to the queue, otherwise false.
+         */
+        bool push(T&& data) { return try_emplace(std::move(data)); }
+
+        /**
+         * Pushes a new object to the back of the queue. The object is constructed in-place. This function will return
+         * immediately if the queue is full.
+         * @param[in] args The arguments to forward to the constructor of the object.
+         * @return true if an object was successfully emplaced in the queue, otherwise false.
+         */
+        template <typename... Args>
+        bool emplace(Args&&... args) {
+            return try_emplace(std::forward<Args>(args)...);
+        }
+
+        /**
+         * Pops an object from the front of the queue without blocking. This function will return immediately if the
+         * queue is empty.
+         * @param[out] data A reference to where the popped object will be stored.
+         * @return true if an object was popped from the front of the queue, otherwise false.
+         */
+        bool pop(T& data) { return try_pop(data); }
+
+        /**
+         * Pops an object from the front of the queue. This function will wait indefinitely for an object to be pushed
+         * to the queue if the queue is empty.
+         * @param[out] data A reference to where the popped object will be stored.
+         * @return true if an object was popped from the front of the queue, otherwise false.
+         */
+        bool wait_and_pop(T& data) {
+            detail::wait_for_pop(m_event_count, [this, &data]() { return try_pop(data); });
+            return true;
+        }
+
+        /**
+         * Pops an object from the front of the queue. This function will wait for as long as the specified timeout for
+         * an object to be pushed to the queue if the queue is empty.
+         * @param[out] data A reference to where the popped object will be stored.
+         * @param[in] timeout A reference to a @c std::chrono::duration of how long this function should wait before
+         * returning.
+         * @return true if an object was popped from the front of the queue, otherwise false.
+         */
+        template <typename Rep, typename Period>
+        bool wait_and_pop(T& data, const std::chrono::duration<Rep, Period>& timeout) {
+            return detail::wait_for_pop(m_event_count, [this, &data]() { return try_pop(data); }, timeout);
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,380 @@
+/*
+ * segmented_queue.h - Unbounded lock-free Multi Producer Multi Consumer queue implementation
+ * Copyright (C) 2021 James Triantafylos
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MPMCPLUSPLUS_SEGMENTED_QUEUE_H
+#define MPMCPLUSPLUS_SEGMENTED_QUEUE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+#include "mpmcplusplus/detail.h"
+
+namespace mpmcplusplus {
+    /**
+     * An unbounded, lock-free queue built from a linked list of fixed-size segments of sequence-numbered slots.
+     *
+     * Producers and consumers claim positions from two global counters with a single compare-and-swap, exactly like
+     * RingQueue, and every position maps to one slot of one segment. The producer that fills the last slot of a segment
+     * links the next one, but any producer that finds the end of the list before that happens links a segment itself,
+     * so a producer that is preempted or blocked in the allocator never holds up the others. Segments that have been
+     * fully drained, or that lost the race to be linked, are pushed onto a free list and reused for later positions
+     * instead of being freed, which keeps the steady state free of heap allocations. Memory is only returned when the
+     * queue is destroyed.
+     *
+     * Segments are identified by the first position they hold, which is unique for the lifetime of the queue. Threads
+     * that race with a segment being recycled notice that its base position changed and simply retry, so a stale
+     * segment pointer is never used to publish or consume an object. A segment only gets its base position once it has
+     * been linked, and any thread that walks past the link can hand it over, so a segment that lost the race to be
+     * linked never takes an object.
+     * @tparam T The type of object the queue will be storing.
+     * @tparam SegmentCapacity The number of slots in each segment.
+     */
+    template <typename T, std::size_t SegmentCapacity = 256>
+    class SegmentedQueue {
+        static_assert(SegmentCapacity > 1, "SegmentCapacity must be greater than one");
+
+      private:
+        struct Slot {
+            std::atomic<std::size_t> sequence;
+            typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+        };
+
+        struct Segment {
+            std::atomic<std::size_t> base;
+            std::atomic<std::uintptr_t> next;
+            std::atomic<std::size_t> consumed;
+            Segment* next_free;
+            Slot slots[SegmentCapacity];
+        };
+
+        // A base position no real segment can have. Segments are given it while they are being re-initialized.
+        static constexpr std::size_t RECYCLING = ~static_cast<std::size_t>(0);
+        // Set in the base position of a segment that is waiting to be linked. It keeps the base above every position,
+        // so nothing is pushed to or popped from the segment until publish() clears it.
+        static constexpr std::size_t PENDING = ~(~static_cast<std::size_t>(0) >> 1);
+
+        char m_pad_0[detail::CACHE_LINE_SIZE];
+        std::atomic<std::size_t> m_enqueue_position;
+        std::atomic<Segment*> m_tail_segment;
+        char m_pad_1[detail::CACHE_LINE_SIZE];
+        std::atomic<std::size_t> m_dequeue_position;
+        std::atomic<Segment*> m_head_segment;
+        char m_pad_2[detail::CACHE_LINE_SIZE];
+        std::atomic<Segment*> m_free_segments;
+        std::atomic_flag m_taking_free_segment;
+        std::atomic_flag m_retiring;
+        detail::EventCount m_event_count;
+
+        // The final segment holds a marker made from its own base position in place of a next pointer. Linking is a
+        // compare-and-swap from that marker, so a producer holding a stale pointer to a segment that has since been
+        // recycled can never link a segment after the wrong incarnation of it.
+        static std::uintptr_t end_marker(std::size_t base) { return (static_cast<std::uintptr_t>(base) << 1) | 1; }
+
+        static Segment* next_of(std::uintptr_t next) {
+            return (next & 1) != 0 ? nullptr : reinterpret_cast<Segment*>(next);
+        }
+
+        static void initialize(Segment* segment, std::size_t base) {
+            segment->base.store(RECYCLING, std::memory_order_relaxed);
+            segment->next.store(end_marker(base), std::memory_order_release);
+            segment->consumed.store(0, std::memory_order_relaxed);
+            for (std::size_t i = 0; i < SegmentCapacity; ++i) {
+                segment->slots[i].sequence.store(base + i, std::memory_order_relaxed);
+            }
+            segment->base.store(base | PENDING, std::memory_order_release);
+        }
+
+        // Gives a linked segment the base position it was initialized for. Any thread that finds the segment behind a
+        // live link may do this, so the producer that linked it never holds the others up. A segment that has been
+        // recycled and initialized for another position in the meantime is left alone.
+        static void publish(Segment* segment, std::size_t base) {
+            std::size_t pending = base | PENDING;
+            segment->base.compare_exchange_strong(pending, base, std::memory_order_acq_rel, std::memory_order_relaxed);
+        }
+
+        // Walks forward from the given segment to the one holding the given position and stores its base position in
+        // base. Returns the final segment if the position lies past the end of the list, and nullptr if the walk raced
+        // with a segment being recycled.
+        static Segment* find(Segment* segment, std::size_t position, std::size_t& base) {
+            for (;;) {
+                base = segment->base.load(std::memory_order_acquire);
+                if (position < base) {
+                    return nullptr;
+                }
+                if (position - base < SegmentCapacity) {
+                    return segment;
+                }
+                Segment* next = next_of(segment->next.load(std::memory_order_acquire));
+                if (segment->base.load(std::memory_order_acquire) != base) {
+                    return nullptr;
+                }
+                if (next == nullptr) {
+                    return segment;
+                }
+                publish(next, base + SegmentCapacity);
+                segment = next;
+            }
+        }
+
+        // Only one thread pops the free list at a time, which rules out ABA on the pop. Others that find the flag taken
+        // allocate a new segment rather than wait for it.
+        Segment* take_free_segment() {
+            Segment* segment = nullptr;
+            if (!m_taking_free_segment.test_and_set(std::memory_order_acquire)) {
+                segment = m_free_segments.load(std::memory_order_acquire);
+                while (segment != nullptr &&
+                       !m_free_segments.compare_exchange_weak(segment, segment->next_free, std::memory_order_acquire)) {
+                }
+                m_taking_free_segment.clear(std::memory_order_release);
+            }
+            return segment != nullptr ? segment : new Segment();
+        }
+
+        // Links a segment after the given final segment, whose base position is base, unless another producer got
+        // there first, and moves the tail forward.
+        void extend(Segment* last, std::size_t base) {
+            Segment* segment = take_free_segment();
+            initialize(segment, base + SegmentCapacity);
+            std::uintptr_t expected = end_marker(base);
+            if (last->next.compare_exchange_strong(expected, reinterpret_cast<std::uintptr_t>(segment),
+                                                   std::memory_order_acq_rel, std::memory_order_acquire)) {
+                publish(segment, base + SegmentCapacity);
+            } else {
+                recycle(segment);
+                segment = next_of(expected);
+                if (segment == nullptr) {
+                    return;
+                }
+            }
+            m_tail_segment.compare_exchange_strong(last, segment, std::memory_order_release, std::memory_order_relaxed);
+        }
+
+        void recycle(Segment* segment) {
+            Segment* top = m_free_segments.load(std::memory_order_relaxed);
+            do {
+                segment->next_free = top;
+            } while (!m_free_segments.compare_exchange_weak(top, segment, std::memory_order_release));
+        }
+
+        bool head_is_drained() {
+            Segment* head = m_head_segment.load(std::memory_order_seq_cst);
+            return head->consumed.load(std::memory_order_seq_cst) == SegmentCapacity &&
+                   next_of(head->next.load(std::memory_order_acquire)) != nullptr;
+        }
+
+        // Moves the head past every fully consumed segment and recycles them. Only one thread does this at a time;
+        // others that find the flag taken leave the work to it.
+        void retire_drained_segments() {
+            while (head_is_drained()) {
+                if (m_retiring.test_and_set(std::memory_order_acquire)) {
+                    return;
+                }
+                Segment* head = m_head_segment.load(std::memory_order_relaxed);
+                while (head->consumed.load(std::memory_order_seq_cst) == SegmentCapacity) {
+                    Segment* next = next_of(head->next.load(std::memory_order_acquire));
+                    if (next == nullptr) {
+                        break;
+                    }
+                    publish(next, head->base.load(std::memory_order_relaxed) + SegmentCapacity);
+                    m_head_segment.store(next, std::memory_order_seq_cst);
+                    recycle(head);
+                    head = next;
+                }
+                m_retiring.clear(std::memory_order_release);
+            }
+        }
+
+        template <typename... Args>
+        bool try_emplace(Args&&... args) {
+            for (;;) {
+                std::size_t position = m_enqueue_position.load(std::memory_order_relaxed);
+                std::size_t base;
+                Segment* segment = find(m_tail_segment.load(std::memory_order_acquire), position, base);
+                if (segment == nullptr) {
+                    // The tail was recycled under us, so walk from the head instead.
+                    segment = find(m_head_segment.load(std::memory_order_acquire), position, base);
+                    if (segment == nullptr) {
+                        std::this_thread::yield();
+                        continue;
+                    }
+                }
+                if (position - base >= SegmentCapacity) {
+                    extend(segment, base);
+                    continue;
+                }
+                Slot& slot = segment->slots[position - base];
+                if (slot.sequence.load(std::memory_order_acquire) != position) {
+                    continue;
+                }
+                if (!m_enqueue_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    continue;
+                }
+                new (&slot.storage) T(std::forward<Args>(args)...);
+                slot.sequence.store(position + 1, std::memory_order_release);
+                m_event_count.notify_one();
+                if (position - base == SegmentCapacity - 1) {
+                    extend(segment, base);
+                }
+                return true;
+            }
+        }
+
+        bool try_pop(T& data) {
+            for (;;) {
+                std::size_t position = m_dequeue_position.load(std::memory_order_relaxed);
+                std::size_t base;
+                Segment* segment = find(m_head_segment.load(std::memory_order_acquire), position, base);
+                if (segment == nullptr) {
+                    continue;
+                }
+                if (position - base >= SegmentCapacity) {
+                    return false;
+                }
+                Slot& slot = segment->slots[position - base];
+                std::size_t sequence = slot.sequence.load(std::memory_order_acquire);
+                if (sequence != position + 1) {
+                    if (sequence == position && m_dequeue_position.load(std::memory_order_relaxed) == position) {
+                        return false;
+                    }
+                    continue;
+                }
+                if (!m_dequeue_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    continue;
+                }
+                T* object = reinterpret_cast<T*>(&slot.storage);
+                data = std::move(*object);
+                object->~T();
+                if (segment->consumed.fetch_add(1, std::memory_order_seq_cst) + 1 == SegmentCapacity ||
+                    position == base) {
+                    retire_drained_segments();
+                }
+                return true;
+            }
+        }
+
+      public:
+        /**
+         * Constructs an empty queue holding a single segment.
+         */
+        SegmentedQueue() : m_enqueue_position(0), m_tail_segment(new Segment()), m_dequeue_position(0) {
+            Segment* segment = m_tail_segment.load(std::memory_order_relaxed);
+            initialize(segment, 0);
+            publish(segment, 0);
+            m_head_segment.store(segment, std::memory_order_relaxed);
+            m_free_segments.store(nullptr, std::memory_order_relaxed);
+            m_taking_free_segment.clear();
+            m_retiring.clear();
+        }
+
+        SegmentedQueue(const SegmentedQueue&) = delete;
+        SegmentedQueue& operator=(const SegmentedQueue&) = delete;
+
+        ~SegmentedQueue() {
+            const std::size_t begin = m_dequeue_position.load(std::memory_order_relaxed);
+            const std::size_t end = m_enqueue_position.load(std::memory_order_relaxed);
+            Segment* segment = m_head_segment.load(std::memory_order_relaxed);
+            while (segment != nullptr) {
+                std::size_t base = segment->base.load(std::memory_order_relaxed);
+                for (std::size_t i = 0; i < SegmentCapacity; ++i) {
+                    if (base + i >= begin && base + i < end) {
+                        reinterpret_cast<T*>(&segment->slots[i].storage)->~T();
+                    }
+                }
+                Segment* next = next_of(segment->next.load(std::memory_order_relaxed));
+                delete segment;
+                segment = next;
+            }
+            segment = m_free_segments.load(std::memory_order_relaxed);
+            while (segment != nullptr) {
+                Segment* next = segment->next_free;
+                delete segment;
+                segment = next;
+            }
+        }
+
+        /**
+         * Pushes the given object to the back of the queue.
+         * @param[in] data The const lvalue reference to be pushed to the queue.
+         * @return true if an object was successfully pushed to the queue, otherwise false.
+         */
+        bool push(const T& data) { return try_emplace(data); }
+
+        /**
+         * Pushes the given object to the back of the queue.
+         * @param[in] data The rvalue reference to be pushed to the queue.
+         * @return true if an object was successfully pushed to the queue, otherwise false.
+         */
+        bool push(T&& data) { return try_emplace(std::move(data)); }
+
+        /**
+         * Pushes a new object to the back of the queue. The object is constructed in-place.
+         * @param[in] args The arguments to forward to the constructor of the object.
+         * @return true if an object was successfully emplaced in the queue, otherwise false.
+         */
+        template <typename... Args>
+        bool emplace(Args&&... args) {
+            return try_emplace(std::forward<Args>(args)...);
+        }
+
+        /**
+         * Pops an object from the front of the queue without blocking. This function will return immediately if the
+         * queue is empty.
+         * @param[out] data A reference to where the popped object will be stored.
+         * @return true if an object was popped from the front of the queue, otherwise false.
+         */
+        bool pop(T& data) { return try_pop(data); }
+
+        /**
+         * Pops an object from the front of the queue. This function will wait indefinitely for an object to be pushed
+         * to the queue if the queue is empty.
+         * @param[out] data A reference to where the popped object will be stored.
+         * @return true if an object was popped from the front of the queue, otherwise false.
+         */
+        bool wait_and_pop(T& data) {
+            detail::wait_for_pop(m_event_count, [this, &data]() { return try_pop(data); });
+            return true;
+        }
+
+        /**
+         * Pops an object from the front of the queue. This function will wait for as long as the specified timeout for
+         * an object to be pushed to the queue if the queue is empty.
+         * @param[out] data A reference to where the popped object will be stored.
+         * @param[in] timeout A reference to a @c std::chrono::duration of how long this function should wait before
+         * returning.
+         * @return true if an object was popped from the front of the queue, otherwise false.
+         */
+        template <typename Rep, typename Period>
+        bool wait_and_pop(T& data, const std::chrono::duration<Rep, Period>& timeout) {
+            return detail::wait_for_pop(m_event_count, [this, &data]() { return try_pop(data); }, timeout);
+        }
+    };
+
+    template <typename T, std::size_t SegmentCapacity>
+    constexpr std::size_t SegmentedQueue<T, SegmentCapacity>::RECYCLING;
+
+    template <typename T, std::size_t SegmentCapacity>
+    constexpr std::size_t SegmentedQueue<T, SegmentCapacity>::PENDING;
+}
+
+#endif
@@ -0,0 +1,158 @@
+/*
+ * select.h - Waiting on several mpmcplusplus::Queue objects at once
+ * Copyright (C) 2021 James Triantafylos
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MPMCPLUSPLUS_SELECT_H
+#define MPMCPLUSPLUS_SELECT_H
+
+#include <chrono>
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+
+#include "mpmcplusplus/detail.h"
+#include "mpmcplusplus/mpmcplusplus.h"
+
+namespace mpmcplusplus {
+    namespace detail {
+        /**
+         * Gives Select access to the listener list of a Queue.
+         */
+        struct SelectAccess {
+            template <typename Q>
+            static void attach(Q& queue, EventCount* listener) {
+                queue.add_listener(listener);
+            }
+
+            template <typename Q>
+            static void detach(Q& queue, EventCount* listener) {
+                queue.remove_listener(listener);
+            }
+        };
+    }
+
+    /**
+     * Pops from whichever of several queues has an object first, blocking on all of them at once.
+     *
+     * A Select registers its own event count with every queue it was constructed with, and those queues notify it
+     * after each push. A thread waiting in wait_and_pop therefore sleeps until one of the queues receives an object,
+     * without polling or short timeouts. The queues are tried in the order they were given, so earlier queues take
+     * priority when several have objects, which suits for example a control queue listed before a data queue. The
+     * queues must outlive the Select. The queues can still be used directly while a Select is attached to them.
+     * @tparam Queues The types of the queues, which must all be instantiations of Queue with the same object type.
+     */
+    template <typename... Queues>
+    class Select {
+        static_assert(sizeof...(Queues) > 0, "Select needs at least one queue");
+
+      public:
+        /**
+         * The type of object the queues are storing.
+         */
+        typedef typename std::tuple_element<0, std::tuple<Queues...>>::type::value_type value_type;
+
+      private:
+        std::tuple<Queues&...> m_queues;
+        detail::EventCount m_event_count;
+
+        template <std::size_t I>
+        typename std::enable_if<I == sizeof...(Queues)>::type attach_from() {}
+
+        template <std::size_t I>
+        typename std::enable_if<(I < sizeof...(Queues))>::type attach_from() {
+            detail::SelectAccess::attach(std::get<I>(m_queues), &m_event_count);
+            attach_from<I + 1>();
+        }
+
+        template <std::size_t I>
+        typename std::enable_if<I == sizeof...(Queues)>::type detach_from() {}
+
+        template <std::size_t I>
+        typename std::enable_if<(I < sizeof...(Queues))>::type detach_from() {
+            detail::SelectAccess::detach(std::get<I>(m_queues), &m_event_count);
+            detach_from<I + 1>();
+        }
+
+        template <std::size_t I>
+        typename std::enable_if<I == sizeof...(Queues), bool>::type try_pop_from(std::size_t&, value_type&) {
+            return false;
+        }
+
+        template <std::size_t I>
+        typename std::enable_if<(I < sizeof...(Queues)), bool>::type try_pop_from(std::size_t& index,
+                                                                                   value_type& data) {
+            static_assert(std::is_same<typename std::tuple_element<I, std::tuple<Queues...>>::type::value_type,
+                                       value_type>::value,
+                          "all queues must store the same type of object");
+            if (std::get<I>(m_queues).pop(data)) {
+                index = I;
+                return true;
+            }
+            return try_pop_from<I + 1>(index, data);
+        }
+
+      public:
+        /**
+         * Attaches to the given queues.
+         * @param[in] queues The queues to pop from, in order of priority.
+         */
+        explicit Select(Queues&... queues) : m_queues(queues...) { attach_from<0>(); }
+
+        Select(const Select&) = delete;
+        Select& operator=(const Select&) = delete;
+
+        ~Select() { detach_from<0>(); }
+
+        /**
+         * Pops an object from the first queue that has one without blocking. This function will return immediately if
+         * all queues are empty.
+         * @param[out] index A reference to where the position of the queue the object was popped from will be stored.
+         * @param[out] data A reference to where the popped object will be stored.
+         * @return true if an object was popped, otherwise false.
+         */
+        bool pop(std::size_t& index, value_type& data) { return try_pop_from<0>(index, data); }
+
+        /**
+         * Pops an object from the first queue that has one. This function will wait indefinitely for an object to be
+         * pushed to any of the queues if all of them are empty.
+         * @param[out] index A reference to where the position of the queue the object was popped from will be stored.
+         * @param[out] data A reference to where the popped object will be stored.
+         * @return true if an object was popped, otherwise false.
+         */
+        bool wait_and_pop(std::size_t& index, value_type& data) {
+            detail::wait_for_pop(m_event_count, [this, &index, &data]() { return try_pop_from<0>(index, data); });
+            return true;
+        }
+
+        /**
+         * Pops an object from the first queue that has one. This function will wait for as long as the specified
+         * timeout for an object to be pushed to any of the queues if all of them are empty.
+         * @param[out] index A reference to where the position of the queue the object was popped from will be stored.
+         * @param[out] data A reference to where the popped object will be stored.
+         * @param[in] timeout A reference to a @c std::chrono::duration of how long this function should wait before
+         * returning.
+         * @return true if an object was popped, otherwise false.
+         */
+        template <typename Rep, typename Period>
+        bool wait_and_pop(std::size_t& index, value_type& data, const std::chrono::duration<Rep, Period>& timeout) {
+            return detail::wait_for_pop(
+                m_event_count, [this, &index, &data]() { return try_pop_from<0>(index, data); }, timeout);
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,171 @@
+/*
+ * sharded_queue.h - Sharded Multi Producer Multi Consumer queue implementation
+ * Copyright (C) 2021 James Triantafylos
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MPMCPLUSPLUS_SHARDED_QUEUE_H
+#define MPMCPLUSPLUS_SHARDED_QUEUE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <utility>
+
+#include "mpmcplusplus/detail.h"
+
+namespace mpmcplusplus {
+    /**
+     * An unbounded queue split into independently locked shards.
+     *
+     * Every thread has a home shard chosen from its thread index. Pushes always go to the home shard, and pops try
+     * the home shard first before stealing from the others, so threads that both produce and consume mostly stay on
+     * their own lock. Objects pushed by one thread are popped in the order they were pushed relative to each other,
+     * but there is no ordering between objects that landed in different shards.
+     * @tparam T The type of object the queue will be storing.
+     */
+    template <typename T>
+    class ShardedQueue {
+      private:
+        struct Shard {
+            std::mutex mutex;
+            std::queue<T> backing_queue;
+            std::atomic<std::size_t> size;
+            char pad[detail::CACHE_LINE_SIZE];
+
+            Shard() : size(0) {}
+        };
+
+        const std::size_t m_shard_count;
+        std::unique_ptr<Shard[]> m_shards;
+        detail::EventCount m_event_count;
+
+        Shard& home_shard() { return m_shards[detail::thread_index() % m_shard_count]; }
+
+        template <typename... Args>
+        bool emplace_back(Args&&... args) {
+            Shard& shard = home_shard();
+            std::unique_lock<std::mutex> lock(shard.mutex);
+            if (!lock) {
+                return false;
+            }
+            shard.backing_queue.emplace(std::forward<Args>(args)...);
+            shard.size.store(shard.backing_queue.size(), std::memory_order_relaxed);
+            lock.unlock();
+            m_event_count.notify_one();
+            return true;
+        }
+
+        bool try_pop(T& data) {
+            const std::size_t home = detail::thread_index() % m_shard_count;
+            for (std::size_t i = 0; i < m_shard_count; ++i) {
+                Shard& shard = m_shards[(home + i) % m_shard_count];
+                if (shard.size.load(std::memory_order_relaxed) == 0) {
+                    continue;
+                }
+                std::unique_lock<std::mutex> lock(shard.mutex);
+                if (!lock || shard.backing_queue.empty()) {
+                    continue;
+                }
+                data = std::move(shard.backing_queue.front());
+                shard.backing_queue.pop();
+                shard.size.store(shard.backing_queue.size(), std::memory_order_relaxed);
+                return true;
+            }
+            return false;
+        }
+
+      public:
+        /**
+         * Constructs an empty queue.
+         * @param[in] shard_count The number of shards to split the queue into. Defaults to the number of hardware
+         * threads.
+         */
+        explicit ShardedQueue(std::size_t shard_count = std::thread::hardware_concurrency())
+            : m_shard_count(shard_count == 0 ? 1 : shard_count), m_shards(new Shard[m_shard_count]) {}
+
+        ShardedQueue(const ShardedQueue&) = delete;
+        ShardedQueue& operator=(const ShardedQueue&) = delete;
+
+        /**
+         * Returns the number of shards the queue is split into.
+         * @return The shard count of the queue.
+         */
+        std::size_t shard_count() const { return m_shard_count; }
+
+        /**
+         * Pushes the given object to the back of the calling thread's home shard.
+         * @param[in] data The const lvalue reference to be pushed to the queue.
+         * @return true if an object was successfully pushed to the queue, otherwise false.
+         */
+        bool push(const T& data) { return emplace_back(data); }
+
+        /**
+         * Pushes the given object to the back of the calling thread's home shard.
+         * @param[in] data The rvalue reference to be pushed to the queue.
+         * @return true if an object was successfully pushed to the queue, otherwise false.
+         */
+        bool push(T&& data) { return emplace_back(std::move(data)); }
+
+        /**
+         * Pushes a new object to the back of the calling thread's home shard. The object is constructed in-place.
+         * @param[in] args The arguments to forward to the constructor of the object.
+         * @return true if an object was successfully emplaced in the queue, otherwise false.
+         */
+        template <typename... Args>
+        bool emplace(Args&&... args) {
+            return emplace_back(std::forward<Args>(args)...);
+        }
+
+        /**
+         * Pops an object from the front of the calling thread's home shard, or from another shard if the home shard is
+         * empty. This function will return immediately if every shard is empty.
+         * @param[out] data A reference to where the popped object will be stored.
+         * @return true if an object was popped from the queue, otherwise false.
+         */
+        bool pop(T& data) { return try_pop(data); }
+
+        /**
+         * Pops an object from the front of the calling thread's home shard, or from another shard if the home shard is
+         * empty. This function will wait indefinitely for an object to be pushed to the queue if every shard is empty.
+         * @param[out] data A reference to where the popped object will be stored.
+         * @return true if an object was popped from the queue, otherwise false.
+         */
+        bool wait_and_pop(T& data) {
+            detail::wait_for_pop(m_event_count, [this, &data]() { return try_pop(data); });
+            return true;
+        }
+
+        /**
+         * Pops an object from the front of the calling thread's home shard, or from another shard if the home shard is
+         * empty. This function will wait for as long as the specified timeout for an object to be pushed to the queue
+         * if every shard is empty.
+         * @param[out] data A reference to where the popped object will be stored.
+         * @param[in] timeout A reference to a @c std::chrono::duration of how long this function should wait before
+         * returning.
+         * @return true if an object was popped from the queue, otherwise false.
+         */
+        template <typename Rep, typename Period>
+        bool wait_and_pop(T& data, const std::chrono::duration<Rep, Period>& timeout) {
+            return detail::wait_for_pop(m_event_count, [this, &data]() { return try_pop(data); }, timeout);
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,396 @@
+/*
+ * shared_memory_queue.h - Multi Producer Multi Consumer queue shared between processes
+ * Copyright (C) 2021 James Triantafylos
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MPMCPLUSPLUS_SHARED_MEMORY_QUEUE_H
+#define MPMCPLUSPLUS_SHARED_MEMORY_QUEUE_H
+
+#if defined(__linux__)
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <new>
+#include <string>
+#include <system_error>
+#include <type_traits>
+
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "mpmcplusplus/detail.h"
+
+namespace mpmcplusplus {
+    namespace detail {
+        /**
+         * An event count that lives in shared memory and parks waiters of any process on a shared futex.
+         *
+         * It has the same interface as EventCount, so it can be used with wait_for_pop. Notifying only makes a system
+         * call when some thread is actually asleep.
+         */
+        class SharedEventCount {
+          private:
+            std::atomic<std::uint32_t> m_waiters;
+            std::atomic<std::uint32_t> m_epoch;
+
+            long futex(int operation, std::uint32_t value, const struct timespec* timeout) {
+                return syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&m_epoch), operation, value, timeout,
+                               nullptr, 0);
+            }
+
+            void notify(int count) {
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                if (m_waiters.load(std::memory_order_relaxed) == 0) {
+                    return;
+                }
+                m_epoch.fetch_add(1, std::memory_order_seq_cst);
+                futex(FUTEX_WAKE, count, nullptr);
+            }
+
+          public:
+            SharedEventCount() : m_waiters(0), m_epoch(0) {}
+
+            SharedEventCount(const SharedEventCount&) = delete;
+            SharedEventCount& operator=(const SharedEventCount&) = delete;
+
+            /**
+             * Registers the calling thread as a waiter. Must be followed by exactly one call to either wait(),
+             * wait_until() or cancel_wait().
+             * @return The key to pass to wait() or wait_until().
+             */
+            std::uint64_t prepare_wait() {
+                m_waiters.fetch_add(1, std::memory_order_seq_cst);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                return m_epoch.load(std::memory_order_seq_cst);
+            }
+
+            /**
+             * Unregisters a waiter whose condition became true after prepare_wait().
+             */
+            void cancel_wait() { m_waiters.fetch_sub(1, std::memory_order_seq_cst); }
+
+            /**
+             * Blocks until a notification is issued after the matching prepare_wait().
+             * @param[in] key The key returned by prepare_wait().
+             */
+            void wait(std::uint64_t key) {
+                const std::uint32_t epoch = static_cast<std::uint32_t>(key);
+                while (m_epoch.load(std::memory_order_seq_cst) == epoch) {
+                    futex(FUTEX_WAIT, epoch, nullptr);
+                }
+                m_waiters.fetch_sub(1, std::memory_order_seq_cst);
+            }
+
+            /**
+             * Blocks until a notification is issued after the matching prepare_wait() or the deadline passes.
+             * @param[in] key The key returned by prepare_wait().
+             * @param[in] deadline The point in time after which this function gives up waiting.
+             * @return true if a notification was received, otherwise false.
+             */
+            template <typename Clock, typename Duration>
+            bool wait_until(std::uint64_t key, const std::chrono::time_point<Clock, Duration>& deadline) {
+                const std::uint32_t epoch = static_cast<std::uint32_t>(key);
+                bool notified = true;
+                while (m_epoch.load(std::memory_order_seq_cst) == epoch) {
+                    const typename Clock::duration remaining = deadline - Clock::now();
+                    if (remaining <= Clock::duration::zero()) {
+                        notified = false;
+                        break;
+                    }
+                    const std::chrono::nanoseconds nanoseconds =
+                        std::chrono::duration_cast<std::chrono::nanoseconds>(remaining);
+                    struct timespec relative;
+                    relative.tv_sec = static_cast<std::time_t>(nanoseconds.count() / 1000000000);
+                    relative.tv_nsec = static_cast<long>(nanoseconds.count() % 1000000000);
+                    futex(FUTEX_WAIT, epoch, &relative);
+                }
+                m_waiters.fetch_sub(1, std::memory_order_seq_cst);
+                return notified;
+            }
+
+            /**
+             * Wakes up one waiting thread, if any.
+             */
+            void notify_one() { notify(1); }
+
+            /**
+             * Wakes up every waiting thread, if any.
+             */
+            void notify_all() { notify(INT_MAX); }
+        };
+    }
+
+    /**
+     * A fixed-capacity, lock-free queue that lives in a named POSIX shared memory segment, so that producers and
+     * consumers may be in different processes.
+     *
+     * One process creates the segment with a capacity and any number of processes open it by name. The segment holds
+     * a ring of sequence-numbered slots like RingQueue and refers to them only by index, so every process may map it
+     * at a different address. Objects are copied into the slots byte for byte, which is why they must be trivially
+     * copyable and must not point into the memory of one process. Consumers blocked in wait_and_pop sleep on a
+     * process-shared futex in the segment that producers only wake when someone is actually asleep, so handing an
+     * object to another process costs about the same as a push within one process.
+     *
+     * The segment stays alive after every queue referring to it has been destroyed, until unlink() is called with its
+     * name. Failing to create, open or map a segment throws @c std::system_error.
+     * @tparam T The type of object the queue will be storing. Must be trivially copyable.
+     */
+    template <typename T>
+    class SharedMemoryQueue {
+        static_assert(std::is_trivially_copyable<T>::value, "T must be trivially copyable");
+        static_assert(ATOMIC_LLONG_LOCK_FREE == 2 && ATOMIC_INT_LOCK_FREE == 2,
+                      "shared atomics must be lock-free to work across processes");
+
+      private:
+        static constexpr std::uint32_t MAGIC = 0x6d706d63;
+
+        struct Slot {
+            std::atomic<std::uint64_t> sequence;
+            typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+        };
+
+        struct Header {
+            std::atomic<std::uint32_t> magic;
+            std::uint32_t object_size;
+            std::uint64_t mask;
+            char pad_0[detail::CACHE_LINE_SIZE];
+            std::atomic<std::uint64_t> tail;
+            char pad_1[detail::CACHE_LINE_SIZE];
+            std::atomic<std::uint64_t> head;
+            char pad_2[detail::CACHE_LINE_SIZE];
+            detail::SharedEventCount event_count;
+        };
+
+        static constexpr std::size_t SLOTS_OFFSET =
+            (sizeof(Header) + alignof(Slot) - 1) / alignof(Slot) * alignof(Slot);
+
+        void* m_mapping;
+        std::size_t m_mapping_size;
+        Header* m_header;
+        Slot* m_slots;
+
+        static std::size_t segment_size(std::size_t capacity) { return SLOTS_OFFSET + capacity * sizeof(Slot); }
+
+        static std::system_error error(const char* what) {
+            return std::system_error(errno, std::generic_category(), what);
+        }
+
+        void map(int fd, std::size_t size) {
+            m_mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            if (m_mapping == MAP_FAILED) {
+                std::system_error mmap_error = error("mmap");
+                close(fd);
+                throw mmap_error;
+            }
+            close(fd);
+            m_mapping_size = size;
+            m_header = static_cast<Header*>(m_mapping);
+            m_slots = reinterpret_cast<Slot*>(static_cast<char*>(m_mapping) + SLOTS_OFFSET);
+        }
+
+        bool try_push(const T& data) {
+            const std::uint64_t mask = m_header->mask;
+            std::uint64_t position = m_header->tail.load(std::memory_order_relaxed);
+            for (;;) {
+                Slot& slot = m_slots[position & mask];
+                std::uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+                std::int64_t difference = static_cast<std::int64_t>(sequence - position);
+                if (difference == 0) {
+                    if (m_header->tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                        std::memcpy(&slot.storage, &data, sizeof(T));
+                        slot.sequence.store(position + 1, std::memory_order_release);
+                        m_header->event_count.notify_one();
+                        return true;
+                    }
+                } else if (difference < 0) {
+                    return false;
+                } else {
+                    position = m_header->tail.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        bool try_pop(T& data) {
+            const std::uint64_t mask = m_header->mask;
+            std::uint64_t position = m_header->head.load(std::memory_order_relaxed);
+            for (;;) {
+                Slot& slot = m_slots[position & mask];
+                std::uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+                std::int64_t difference = static_cast<std::int64_t>(sequence - (position + 1));
+                if (difference == 0) {
+                    if (m_header->head.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                        std::memcpy(&data, &slot.storage, sizeof(T));
+                        slot.sequence.store(position + mask + 1, std::memory_order_release);
+                        return true;
+                    }
+                } else if (difference < 0) {
+                    return false;
+                } else {
+                    position = m_header->head.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+      public:
+        /**
+         * Creates a new shared memory segment holding an empty queue.
+         * @param[in] name The name of the segment, which should start with a slash. A segment of that name must not
+         * already exist.
+         * @param[in] capacity The minimum number of objects the queue can hold. It is rounded up to the next power of
+         * two.
+         */
+        SharedMemoryQueue(const std::string& name, std::size_t capacity) {
+            const std::size_t slot_count = detail::round_up_to_power_of_two(capacity < 2 ? 2 : capacity);
+            const int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, S_IRUSR | S_IWUSR);
+            if (fd == -1) {
+                throw error("shm_open");
+            }
+            if (ftruncate(fd, static_cast<off_t>(segment_size(slot_count))) == -1) {
+                std::system_error ftruncate_error = error("ftruncate");
+                close(fd);
+                shm_unlink(name.c_str());
+                throw ftruncate_error;
+            }
+            try {
+                map(fd, segment_size(slot_count));
+            } catch (...) {
+                shm_unlink(name.c_str());
+                throw;
+            }
+            new (m_header) Header();
+            m_header->object_size = sizeof(T);
+            m_header->mask = slot_count - 1;
+            m_header->tail.store(0, std::memory_order_relaxed);
+            m_header->head.store(0, std::memory_order_relaxed);
+            for (std::size_t i = 0; i < slot_count; ++i) {
+                new (&m_slots[i]) Slot();
+                m_slots[i].sequence.store(i, std::memory_order_relaxed);
+            }
+            m_header->magic.store(MAGIC, std::memory_order_release);
+        }
+
+        /**
+         * Opens the queue in an existing shared memory segment that was created by another SharedMemoryQueue.
+         * @param[in] name The name the segment was created with. The creating constructor must have returned before the
+         * segment is opened.
+         */
+        explicit SharedMemoryQueue(const std::string& name) {
+            const int fd = shm_open(name.c_str(), O_RDWR, 0);
+            if (fd == -1) {
+                throw error("shm_open");
+            }
+            struct stat status;
+            if (fstat(fd, &status) == -1) {
+                std::system_error fstat_error = error("fstat");
+                close(fd);
+                throw fstat_error;
+            }
+            const std::size_t size = static_cast<std::size_t>(status.st_size);
+            if (size < SLOTS_OFFSET) {
+                close(fd);
+                throw std::system_error(EINVAL, std::generic_category(), "segment is not a SharedMemoryQueue");
+            }
+            map(fd, size);
+            if (m_header->magic.load(std::memory_order_acquire) != MAGIC || m_header->object_size != sizeof(T) ||
+                size != segment_size(static_cast<std::size_t>(m_header->mask + 1))) {
+                munmap(m_mapping, m_mapping_size);
+                throw std::system_error(EINVAL, std::generic_category(), "segment is not a SharedMemoryQueue");
+            }
+        }
+
+        SharedMemoryQueue(const SharedMemoryQueue&) = delete;
+        SharedMemoryQueue& operator=(const SharedMemoryQueue&) = delete;
+
+        /**
+         * Unmaps the segment from this process. The segment itself and any objects in it are left intact.
+         */
+        ~SharedMemoryQueue() { munmap(m_mapping, m_mapping_size); }
+
+        /**
+         * Removes the name of a shared memory segment. Processes that have it mapped can keep using it, and it is
+         * freed once the last of them unmaps it.
+         * @param[in] name The name the segment was created with.
+         * @return true if the name was removed, otherwise false.
+         */
+        static bool unlink(const std::string& name) { return shm_unlink(name.c_str()) == 0; }
+
+        /**
+         * Returns the number of objects the queue can hold.
+         * @return The capacity of the queue.
+         */
+        std::size_t capacity() const { return static_cast<std::size_t>(m_header->mask + 1); }
+
+        /**
+         * Pushes the given object to the back of the queue without blocking. This function will return immediately if
+         * the queue is full.
+         * @param[in] data The const lvalue reference to be pushed to the queue.
+         * @return true if an object was successfully pushed to the queue, otherwise false.
+         */
+        bool push(const T& data) { return try_push(data); }
+
+        /**
+         * Pops an object from the front of the queue without blocking. This function will return immediately if the
+         * queue is empty.
+         * @param[out] data A reference to where the popped object will be stored.
+         * @return true if an object was popped from the front of the queue, otherwise false.
+         */
+        bool pop(T& data) { return try_pop(data); }
+
+        /**
+         * Pops an object from the front of the queue. This function will wait indefinitely for an object to be pushed
+         * to the queue by any process if the queue is empty.
+         * @param[out] data A reference to where the popped object will be stored.
+         * @return true if an object was popped from the front of the queue, otherwise false.
+         */
+        bool wait_and_pop(T& data) {
+            detail::wait_for_pop(m_header->event_count, [this, &data]() { return try_pop(data); });
+            return true;
+        }
+
+        /**
+         * Pops an object from the front of the queue. This function will wait for as long as the specified timeout for
+         * an object to be pushed to the queue by any process if the queue is empty.
+         * @param[out] data A reference to where the popped object will be stored.
+         * @param[in] timeout A reference to a @c std::chrono::duration of how long this function should wait before
+         * returning.
+         * @return true if an object was popped from the front of the queue, otherwise false.
+         */
+        template <typename Rep, typename Period>
+        bool wait_and_pop(T& data, const std::chrono::duration<Rep, Period>& timeout) {
+            return detail::wait_for_pop(m_header->event_count, [this, &data]() { return try_pop(data); }, timeout);
+        }
+    };
+
+    template <typename T>
+    constexpr std::uint32_t SharedMemoryQueue<T>::MAGIC;
+
+    template <typename T>
+    constexpr std::size_t SharedMemoryQueue<T>::SLOTS_OFFSET;
+}
+
+#endif
+
+#endif
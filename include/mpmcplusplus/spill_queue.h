@@ -0,0 +1,362 @@
+/*
+ * spill_queue.h - Multi Producer Multi Consumer queue that spills to disk past a memory limit
+ * Copyright (C) 2021 James Triantafylos
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MPMCPLUSPLUS_SPILL_QUEUE_H
+#define MPMCPLUSPLUS_SPILL_QUEUE_H
+
+#if defined(__linux__)
+
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace mpmcplusplus {
+    /**
+     * A codec that writes an object to disk as its raw bytes. This is the default codec of SpillQueue.
+     * @tparam T The type of object to encode. Must be trivially copyable.
+     */
+    template <typename T>
+    struct TriviallyCopyableCodec {
+        static_assert(std::is_trivially_copyable<T>::value, "T must be trivially copyable");
+
+        /**
+         * Returns the number of bytes encode() writes for the given object.
+         * @param[in] object The object to be encoded.
+         * @return The encoded size in bytes.
+         */
+        std::size_t size(const T&) const { return sizeof(T); }
+
+        /**
+         * Writes the given object to the given buffer.
+         * @param[in] object The object to be encoded.
+         * @param[out] data The buffer of size(object) bytes to write to.
+         */
+        void encode(const T& object, unsigned char* data) const { std::memcpy(data, &object, sizeof(T)); }
+
+        /**
+         * Reads an object from the given buffer.
+         * @param[in] data The bytes written by encode().
+         * @param[in] size The number of bytes written by encode().
+         * @param[out] object A reference to where the decoded object will be stored.
+         */
+        void decode(const unsigned char* data, std::size_t, T& object) const { std::memcpy(&object, data, sizeof(T)); }
+    };
+
+    /**
+     * A queue that keeps objects in memory up to a limit and spills any further objects to files on disk, so that a
+     * growing backlog cannot exhaust memory.
+     *
+     * While fewer than the memory limit of objects are queued the queue behaves like Queue. Once the limit is reached,
+     * newly pushed objects are serialised by the codec into append-only segment files that are mapped into memory, and
+     * they keep going there while any object is still spilled, so objects are always popped in the order they were
+     * pushed. As pops free up memory, the oldest spilled objects are paged back in behind the objects already in
+     * memory, so consumers keep popping from memory and the spilled backlog drains as fast as it is consumed. Segment
+     * files are unlinked as soon as they are created, which means they never outlive the process. The pages of a
+     * segment are released as they are read and the segment is unmapped once all of its objects have been popped.
+     *
+     * Failing to create or map a segment file throws @c std::system_error.
+     * @tparam T The type of object the queue will be storing.
+     * @tparam Codec The serialiser for spilled objects. It must provide @c size(object), @c encode(object, data) and
+     * @c decode(data, size, object) members like TriviallyCopyableCodec. T must be default constructible so that
+     * spilled objects can be decoded back into memory.
+     */
+    template <typename T, typename Codec = TriviallyCopyableCodec<T>>
+    class SpillQueue {
+      private:
+        static constexpr std::size_t RECORD_ALIGNMENT = 8;
+
+        struct Segment {
+            unsigned char* data;
+            std::size_t capacity;
+            std::size_t write_offset;
+            std::size_t read_offset;
+            std::size_t released_offset;
+        };
+
+        const std::size_t m_memory_limit;
+        const std::string m_directory;
+        const std::size_t m_segment_size;
+        const std::size_t m_page_size;
+        Codec m_codec;
+        std::queue<T> m_objects;
+        std::deque<Segment> m_segments;
+        std::size_t m_spilled;
+        mutable std::mutex m_mutex;
+        std::condition_variable m_condition_variable;
+
+        static std::size_t record_size(std::size_t size) {
+            return (sizeof(std::uint64_t) + size + RECORD_ALIGNMENT - 1) / RECORD_ALIGNMENT * RECORD_ALIGNMENT;
+        }
+
+        static std::system_error error(const char* what) {
+            return std::system_error(errno, std::generic_category(), what);
+        }
+
+        Segment create_segment(std::size_t capacity) {
+            const std::string pattern = m_directory + "/mpmcplusplus-spill-XXXXXX";
+            std::vector<char> path(pattern.begin(), pattern.end());
+            path.push_back('\0');
+            const int fd = mkstemp(path.data());
+            if (fd == -1) {
+                throw error("mkstemp");
+            }
+            unlink(path.data());
+            // Allocating the blocks up front turns a full disk into an exception here rather than a SIGBUS on a write
+            // to the mapping.
+            const int result = posix_fallocate(fd, 0, static_cast<off_t>(capacity));
+            if (result != 0) {
+                close(fd);
+                throw std::system_error(result, std::generic_category(), "posix_fallocate");
+            }
+            void* data = mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            if (data == MAP_FAILED) {
+                std::system_error mmap_error = error("mmap");
+                close(fd);
+                throw mmap_error;
+            }
+            close(fd);
+            Segment segment = {static_cast<unsigned char*>(data), capacity, 0, 0, 0};
+            return segment;
+        }
+
+        void spill(const T& object) {
+            const std::size_t size = m_codec.size(object);
+            const std::size_t record = record_size(size);
+            if (m_segments.empty() || m_segments.back().capacity - m_segments.back().write_offset < record) {
+                m_segments.push_back(create_segment(record > m_segment_size ? record : m_segment_size));
+            }
+            Segment& segment = m_segments.back();
+            const std::uint64_t header = size;
+            std::memcpy(segment.data + segment.write_offset, &header, sizeof(header));
+            m_codec.encode(object, segment.data + segment.write_offset + sizeof(header));
+            segment.write_offset += record;
+            ++m_spilled;
+        }
+
+        void unspill(T& object) {
+            Segment& segment = m_segments.front();
+            std::uint64_t header;
+            std::memcpy(&header, segment.data + segment.read_offset, sizeof(header));
+            const std::size_t size = static_cast<std::size_t>(header);
+            m_codec.decode(segment.data + segment.read_offset + sizeof(header), size, object);
+            segment.read_offset += record_size(size);
+            --m_spilled;
+            if (segment.read_offset == segment.write_offset) {
+                munmap(segment.data, segment.capacity);
+                m_segments.pop_front();
+                return;
+            }
+            // Give the pages that have been read in full back to the kernel instead of holding on to them until the
+            // whole segment has been popped.
+            const std::size_t read_pages = segment.read_offset / m_page_size * m_page_size;
+            if (read_pages > segment.released_offset) {
+                madvise(segment.data + segment.released_offset, read_pages - segment.released_offset, MADV_DONTNEED);
+                segment.released_offset = read_pages;
+            }
+        }
+
+        template <typename... Args>
+        bool insert(Args&&... args) {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            if (!lock) {
+                return false;
+            }
+            if (m_spilled == 0 && m_objects.size() < m_memory_limit) {
+                m_objects.emplace(std::forward<Args>(args)...);
+            } else {
+                spill(T(std::forward<Args>(args)...));
+            }
+            lock.unlock();
+            m_condition_variable.notify_one();
+            return true;
+        }
+
+        void take_front(T& data) {
+            if (m_objects.empty()) {
+                unspill(data);
+                return;
+            }
+            data = std::move(m_objects.front());
+            m_objects.pop();
+            // Every spilled object is newer than every object in memory, so paging the oldest spilled objects back in
+            // behind them keeps the order.
+            while (m_spilled != 0 && m_objects.size() < m_memory_limit) {
+                m_objects.emplace();
+                unspill(m_objects.back());
+            }
+        }
+
+        bool empty() const { return m_objects.empty() && m_spilled == 0; }
+
+      public:
+        /**
+         * Constructs an empty queue.
+         * @param[in] memory_limit The number of objects kept in memory before further objects are spilled to disk.
+         * @param[in] directory The directory in which to create segment files.
+         * @param[in] segment_size The size in bytes of each segment file. Objects whose record is larger get a segment
+         * of their own.
+         * @param[in] codec The codec used to serialise spilled objects.
+         */
+        SpillQueue(std::size_t memory_limit,
+                   const std::string& directory,
+                   std::size_t segment_size = 64 * 1024 * 1024,
+                   const Codec& codec = Codec())
+            : m_memory_limit(memory_limit),
+              m_directory(directory),
+              m_segment_size(segment_size),
+              m_page_size(static_cast<std::size_t>(sysconf(_SC_PAGESIZE))),
+              m_codec(codec),
+              m_spilled(0) {}
+
+        SpillQueue(const SpillQueue&) = delete;
+        SpillQueue& operator=(const SpillQueue&) = delete;
+
+        ~SpillQueue() {
+            for (typename std::deque<Segment>::iterator segment = m_segments.begin(); segment != m_segments.end();
+                 ++segment) {
+                munmap(segment->data, segment->capacity);
+            }
+        }
+
+        /**
+         * Returns the number of objects in the queue, both in memory and on disk.
+         * @return The size of the queue.
+         */
+        std::size_t size() const {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_objects.size() + m_spilled;
+        }
+
+        /**
+         * Returns the number of objects that are currently spilled to disk.
+         * @return The number of spilled objects.
+         */
+        std::size_t spilled_size() const {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_spilled;
+        }
+
+        /**
+         * Pushes the given object to the back of the queue, spilling it to disk if the memory limit has been reached.
+         * @param[in] data The const lvalue reference to be pushed to the queue.
+         * @return true if an object was successfully pushed to the queue, otherwise false.
+         */
+        bool push(const T& data) { return insert(data); }
+
+        /**
+         * Pushes the given object to the back of the queue, spilling it to disk if the memory limit has been reached.
+         * @param[in] data The rvalue reference to be pushed to the queue.
+         * @return true if an object was successfully pushed to the queue, otherwise false.
+         */
+        bool push(T&& data) { return insert(std::move(data)); }
+
+        /**
+         * Pushes a new object to the back of the queue, spilling it to disk if the memory limit has been reached. The
+         * object is constructed in-place when it is kept in memory.
+         * @param[in] args The arguments to forward to the constructor of the object.
+         * @return true if an object was successfully emplaced in the queue, otherwise false.
+         */
+        template <typename... Args>
+        bool emplace(Args&&... args) {
+            return insert(std::forward<Args>(args)...);
+        }
+
+        /**
+         * Pops an object from the front of the queue without blocking, reading it back from disk if it was spilled.
+         * This function will return immediately if the queue is empty.
+         * @param[out] data A reference to where the popped object will be stored.
+         * @return true if an object was popped from the front of the queue, otherwise false.
+         */
+        bool pop(T& data) {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            if (!lock) {
+                return false;
+            }
+            if (empty()) {
+                return false;
+            }
+            take_front(data);
+            return true;
+        }
+
+        /**
+         * Pops an object from the front of the queue, reading it back from disk if it was spilled. This function will
+         * wait indefinitely for an object to be pushed to the queue if the queue is empty.
+         * @param[out] data A reference to where the popped object will be stored.
+         * @return true if an object was popped from the front of the queue, otherwise false.
+         */
+        bool wait_and_pop(T& data) {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            if (!lock) {
+                return false;
+            }
+            while (empty()) {
+                m_condition_variable.wait(lock);
+            }
+            take_front(data);
+            return true;
+        }
+
+        /**
+         * Pops an object from the front of the queue, reading it back from disk if it was spilled. This function will
+         * wait for as long as the specified timeout for an object to be pushed to the queue if the queue is empty.
+         * @param[out] data A reference to where the popped object will be stored.
+         * @param[in] timeout A reference to a @c std::chrono::duration of how long this function should wait before
+         * returning.
+         * @return true if an object was popped from the front of the queue, otherwise false.
+         */
+        template <typename Rep, typename Period>
+        bool wait_and_pop(T& data, const std::chrono::duration<Rep, Period>& timeout) {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            if (!lock) {
+                return false;
+            }
+            while (empty()) {
+                std::cv_status result = m_condition_variable.wait_for(lock, timeout);
+                if (result == std::cv_status::timeout) {
+                    return false;
+                }
+            }
+            take_front(data);
+            return true;
+        }
+    };
+
+    template <typename T, typename Codec>
+    constexpr std::size_t SpillQueue<T, Codec>::RECORD_ALIGNMENT;
+}
+
+#endif
+
+#endif
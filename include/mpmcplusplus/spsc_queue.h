@@ -0,0 +1,184 @@
+/*
+ * spsc_queue.h - Single Producer Single Consumer queue implementation
+ * Copyright (C) 2021 James Triantafylos
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MPMCPLUSPLUS_SPSC_QUEUE_H
+#define MPMCPLUSPLUS_SPSC_QUEUE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "mpmcplusplus/detail.h"
+
+namespace mpmcplusplus {
+    /**
+     * A fixed-capacity, wait-free queue for exactly one producer thread and one consumer thread.
+     *
+     * The producer owns the tail index and the consumer owns the head index, each on its own cache line. Both sides
+     * keep a private copy of the other side's index and only reload the shared one when the copy says the ring is full
+     * or empty, so in steady state push and pop touch no cache line written by the other thread except the slot itself.
+     * Every push still ends with the full fence of EventCount::notify_one, which is what lets a parked consumer be
+     * woken without a lost wakeup, and takes a mutex only when the consumer is actually parked in wait_and_pop. Calling
+     * push or emplace from more than one thread, or pop or wait_and_pop from more than one thread, at the same time is
+     * undefined behaviour.
+     * @tparam T The type of object the queue will be storing.
+     */
+    template <typename T>
+    class SpscQueue {
+      private:
+        typedef typename std::aligned_storage<sizeof(T), alignof(T)>::type Slot;
+
+        char m_pad_0[detail::CACHE_LINE_SIZE];
+        std::atomic<std::size_t> m_tail;
+        std::size_t m_cached_head;
+        char m_pad_1[detail::CACHE_LINE_SIZE];
+        std::atomic<std::size_t> m_head;
+        std::size_t m_cached_tail;
+        char m_pad_2[detail::CACHE_LINE_SIZE];
+        const std::size_t m_mask;
+        std::unique_ptr<Slot[]> m_slots;
+        detail::EventCount m_event_count;
+
+        template <typename... Args>
+        bool try_emplace(Args&&... args) {
+            const std::size_t tail = m_tail.load(std::memory_order_relaxed);
+            if (tail - m_cached_head > m_mask) {
+                m_cached_head = m_head.load(std::memory_order_acquire);
+                if (tail - m_cached_head > m_mask) {
+                    return false;
+                }
+            }
+            new (&m_slots[tail & m_mask]) T(std::forward<Args>(args)...);
+            m_tail.store(tail + 1, std::memory_order_release);
+            // The fence inside notify_one() orders the store above before the check for a parked consumer. Checking
+            // first without it could miss a consumer that is just about to park.
+            m_event_count.notify_one();
+            return true;
+        }
+
+        bool try_pop(T& data) {
+            const std::size_t head = m_head.load(std::memory_order_relaxed);
+            if (head == m_cached_tail) {
+                m_cached_tail = m_tail.load(std::memory_order_acquire);
+                if (head == m_cached_tail) {
+                    return false;
+                }
+            }
+            T* object = reinterpret_cast<T*>(&m_slots[head & m_mask]);
+            data = std::move(*object);
+            object->~T();
+            m_head.store(head + 1, std::memory_order_release);
+            return true;
+        }
+
+      public:
+        /**
+         * Constructs an empty queue.
+         * @param[in] capacity The minimum number of objects the queue can hold. It is rounded up to the next power of
+         * two.
+         */
+        explicit SpscQueue(std::size_t capacity)
+            : m_tail(0),
+              m_cached_head(0),
+              m_head(0),
+              m_cached_tail(0),
+              m_mask(detail::round_up_to_power_of_two(capacity) - 1),
+              m_slots(new Slot[m_mask + 1]) {}
+
+        SpscQueue(const SpscQueue&) = delete;
+        SpscQueue& operator=(const SpscQueue&) = delete;
+
+        ~SpscQueue() {
+            std::size_t tail = m_tail.load(std::memory_order_relaxed);
+            for (std::size_t head = m_head.load(std::memory_order_relaxed); head != tail; ++head) {
+                reinterpret_cast<T*>(&m_slots[head & m_mask])->~T();
+            }
+        }
+
+        /**
+         * Returns the number of objects the queue can hold.
+         * @return The capacity of the queue.
+         */
+        std::size_t capacity() const { return m_mask + 1; }
+
+        /**
+         * Pushes the given object to the back of the queue. This function will return immediately if the queue is
+         * full. Must only be called from the producer thread.
+         * @param[in] data The const lvalue reference to be pushed to the queue.
+         * @return true if an object was successfully pushed to the queue, otherwise false.
+         */
+        bool push(const T& data) { return try_emplace(data); }
+
+        /**
+         * Pushes the given object to the back of the queue. This function will return immediately if the queue is
+         * full. Must only be called from the producer thread.
+         * @param[in] data The rvalue reference to be pushed to the queue.
+         * @return true if an object was successfully pushed to the queue, otherwise false.
+         */
+        bool push(T&& data) { return try_emplace(std::move(data)); }
+
+        /**
+         * Pushes a new object to the back of the queue. The object is constructed in-place. This function will return
+         * immediately if the queue is full. Must only be called from the producer thread.
+         * @param[in] args The arguments to forward to the constructor of the object.
+         * @return true if an object was successfully emplaced in the queue, otherwise false.
+         */
+        template <typename... Args>
+        bool emplace(Args&&... args) {
+            return try_emplace(std::forward<Args>(args)...);
+        }
+
+        /**
+         * Pops an object from the front of the queue without blocking. This function will return immediately if the
+         * queue is empty. Must only be called from the consumer thread.
+         * @param[out] data A reference to where the popped object will be stored.
+         * @return true if an object was popped from the front of the queue, otherwise false.
+         */
+        bool pop(T& data) { return try_pop(data); }
+
+        /**
+         * Pops an object from the front of the queue. This function will wait indefinitely for an object to be pushed
+         * to the queue if the queue is empty. Must only be called from the consumer thread.
+         * @param[out] data A reference to where the popped object will be stored.
+         * @return true if an object was popped from the front of the queue, otherwise false.
+         */
+        bool wait_and_pop(T& data) {
+            detail::wait_for_pop(m_event_count, [this, &data]() { return try_pop(data); });
+            return true;
+        }
+
+        /**
+         * Pops an object from the front of the queue. This function will wait for as long as the specified timeout for
+         * an object to be pushed to the queue if the queue is empty. Must only be called from the consumer thread.
+         * @param[out] data A reference to where the popped object will be stored.
+         * @param[in] timeout A reference to a @c std::chrono::duration of how long this function should wait before
+         * returning.
+         * @return true if an object was popped from the front of the queue, otherwise false.
+         */
+        template <typename Rep, typename Period>
+        bool wait_and_pop(T& data, const std::chrono::duration<Rep, Period>& timeout) {
+            return detail::wait_for_pop(m_event_count, [this, &data]() { return try_pop(data); }, timeout);
+        }
+    };
+}
+
+#endif
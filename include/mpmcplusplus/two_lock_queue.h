@@ -0,0 +1,180 @@
+/*
+ * two_lock_queue.h - Two-lock Multi Producer Multi Consumer queue implementation
+ * Copyright (C) 2021 James Triantafylos
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MPMCPLUSPLUS_TWO_LOCK_QUEUE_H
+#define MPMCPLUSPLUS_TWO_LOCK_QUEUE_H
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "mpmcplusplus/detail.h"
+
+namespace mpmcplusplus {
+    /**
+     * An unbounded queue with separate locks for producers and consumers.
+     *
+     * This is the two-lock queue of Michael and Scott: a linked list that always starts with a dummy node, so the tail
+     * lock only guards linking new nodes and the head lock only guards unlinking the dummy. Producers therefore only
+     * contend with other producers and consumers only with other consumers. Nodes are allocated and freed outside of
+     * both locks.
+     * @tparam T The type of object the queue will be storing.
+     */
+    template <typename T>
+    class TwoLockQueue {
+      private:
+        struct Node {
+            std::atomic<Node*> next;
+            typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+
+            Node() : next(nullptr) {}
+
+            T* object() { return reinterpret_cast<T*>(&storage); }
+        };
+
+        char m_pad_0[detail::CACHE_LINE_SIZE];
+        std::mutex m_head_mutex;
+        Node* m_head;
+        char m_pad_1[detail::CACHE_LINE_SIZE];
+        std::mutex m_tail_mutex;
+        Node* m_tail;
+        char m_pad_2[detail::CACHE_LINE_SIZE];
+        detail::EventCount m_event_count;
+
+        template <typename... Args>
+        bool link(Args&&... args) {
+            Node* node = new Node();
+            try {
+                new (&node->storage) T(std::forward<Args>(args)...);
+            } catch (...) {
+                delete node;
+                throw;
+            }
+            std::unique_lock<std::mutex> lock(m_tail_mutex);
+            if (!lock) {
+                node->object()->~T();
+                delete node;
+                return false;
+            }
+            m_tail->next.store(node, std::memory_order_release);
+            m_tail = node;
+            lock.unlock();
+            m_event_count.notify_one();
+            return true;
+        }
+
+        bool try_pop(T& data) {
+            std::unique_lock<std::mutex> lock(m_head_mutex);
+            if (!lock) {
+                return false;
+            }
+            Node* dummy = m_head;
+            Node* next = dummy->next.load(std::memory_order_acquire);
+            if (next == nullptr) {
+                return false;
+            }
+            data = std::move(*next->object());
+            next->object()->~T();
+            m_head = next;
+            lock.unlock();
+            delete dummy;
+            return true;
+        }
+
+      public:
+        /**
+         * Constructs an empty queue.
+         */
+        TwoLockQueue() : m_head(new Node()), m_tail(m_head) {}
+
+        TwoLockQueue(const TwoLockQueue&) = delete;
+        TwoLockQueue& operator=(const TwoLockQueue&) = delete;
+
+        ~TwoLockQueue() {
+            Node* next = m_head->next.load(std::memory_order_relaxed);
+            delete m_head;
+            while (next != nullptr) {
+                Node* node = next;
+                next = node->next.load(std::memory_order_relaxed);
+                node->object()->~T();
+                delete node;
+            }
+        }
+
+        /**
+         * Pushes the given object to the back of the queue.
+         * @param[in] data The const lvalue reference to be pushed to the queue.
+         * @return true if an object was successfully pushed to the queue, otherwise false.
+         */
+        bool push(const T& data) { return link(data); }
+
+        /**
+         * Pushes the given object to the back of the queue.
+         * @param[in] data The rvalue reference to be pushed to the queue.
+         * @return true if an object was successfully pushed to the queue, otherwise false.
+         */
+        bool push(T&& data) { return link(std::move(data)); }
+
+        /**
+         * Pushes a new object to the back of the queue. The object is constructed in-place.
+         * @param[in] args The arguments to forward to the constructor of the object.
+         * @return true if an object was successfully emplaced in the queue, otherwise false.
+         */
+        template <typename... Args>
+        bool emplace(Args&&... args) {
+            return link(std::forward<Args>(args)...);
+        }
+
+        /**
+         * Pops an object from the front of the queue without blocking. This function will return immediately if the
+         * queue is empty.
+         * @param[out] data A reference to where the popped object will be stored.
+         * @return true if an object was popped from the front of the queue, otherwise false.
+         */
+        bool pop(T& data) { return try_pop(data); }
+
+        /**
+         * Pops an object from the front of the queue. This function will wait indefinitely for an object to be pushed
+         * to the queue if the queue is empty.
+         * @param[out] data A reference to where the popped object will be stored.
+         * @return true if an object was popped from the front of the queue, otherwise false.
+         */
+        bool wait_and_pop(T& data) {
+            detail::wait_for_pop(m_event_count, [this, &data]() { return try_pop(data); });
+            return true;
+        }
+
+        /**
+         * Pops an object from the front of the queue. This function will wait for as long as the specified timeout for
+         * an object to be pushed to the queue if the queue is empty.
+         * @param[out] data A reference to where the popped object will be stored.
+         * @param[in] timeout A reference to a @c std::chrono::duration of how long this function should wait before
+         * returning.
+         * @return true if an object was popped from the front of the queue, otherwise false.
+         */
+        template <typename Rep, typename Period>
+        bool wait_and_pop(T& data, const std::chrono::duration<Rep, Period>& timeout) {
+            return detail::wait_for_pop(m_event_count, [this, &data]() { return try_pop(data); }, timeout);
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,247 @@
+/*
+ * work_stealing_deque.h - Chase-Lev work-stealing deque implementation
+ * Copyright (C) 2021 James Triantafylos
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MPMCPLUSPLUS_WORK_STEALING_DEQUE_H
+#define MPMCPLUSPLUS_WORK_STEALING_DEQUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "mpmcplusplus/detail.h"
+
+namespace mpmcplusplus {
+    namespace detail {
+        /**
+         * How WorkStealingDeque keeps an object in a ring slot. Small trivially copyable objects are stored in the
+         * slot itself: a thief that reads a slot the owner is overwriting loses its compare-and-swap and throws the
+         * copy away, which needs no clean-up.
+         */
+        template <typename T,
+                  bool Inline = std::is_trivially_copyable<T>::value && std::is_default_constructible<T>::value &&
+                                sizeof(T) <= sizeof(std::uint64_t) && (sizeof(T) & (sizeof(T) - 1)) == 0>
+        struct DequeSlot {
+            typedef T stored_type;
+
+            template <typename... Args>
+            static T store(Args&&... args) {
+                return T(std::forward<Args>(args)...);
+            }
+
+            static void take(T object, T& data) { data = object; }
+
+            static void destroy(T) {}
+        };
+
+        /**
+         * Any other object is boxed in its own allocation, so that a thief never copies an object the owner may be
+         * overwriting.
+         */
+        template <typename T>
+        struct DequeSlot<T, false> {
+            typedef T* stored_type;
+
+            template <typename... Args>
+            static T* store(Args&&... args) {
+                return new T(std::forward<Args>(args)...);
+            }
+
+            static void take(T* object, T& data) {
+                data = std::move(*object);
+                delete object;
+            }
+
+            static void destroy(T* object) { delete object; }
+        };
+    }
+
+    /**
+     * An unbounded work-stealing deque, as described by Chase and Lev.
+     *
+     * The deque has a single owner thread that pushes and pops at the bottom without any read-modify-write operation
+     * except when it races a thief for the last object. Any number of other threads may steal from the top with a
+     * single compare-and-swap. This suits thread pools where each worker owns one deque and only steals from the
+     * others when it runs out of work.
+     *
+     * Trivially copyable objects of up to 8 bytes, such as pointers to tasks or task indices, are stored in the ring
+     * itself, so pushing never allocates. Any other object is boxed in a heap allocation of its own on every push so
+     * that a thief never copies an object the owner may be overwriting; push a pointer or a handle instead to keep
+     * allocations off the owner's path. When the ring fills up the owner doubles it; the old rings are kept alive
+     * until the deque is destroyed because a thief may still be reading from them.
+     * @tparam T The type of object the deque will be storing.
+     */
+    template <typename T>
+    class WorkStealingDeque {
+      private:
+        typedef detail::DequeSlot<T> Slot;
+        typedef typename Slot::stored_type Stored;
+
+        struct Ring {
+            const std::int64_t mask;
+            std::unique_ptr<std::atomic<Stored>[]> slots;
+
+            explicit Ring(std::int64_t capacity) : mask(capacity - 1), slots(new std::atomic<Stored>[capacity]) {}
+
+            std::int64_t capacity() const { return mask + 1; }
+
+            Stored get(std::int64_t index) const { return slots[index & mask].load(std::memory_order_relaxed); }
+
+            void put(std::int64_t index, Stored object) {
+                slots[index & mask].store(object, std::memory_order_relaxed);
+            }
+        };
+
+        char m_pad_0[detail::CACHE_LINE_SIZE];
+        std::atomic<std::int64_t> m_top;
+        char m_pad_1[detail::CACHE_LINE_SIZE];
+        std::atomic<std::int64_t> m_bottom;
+        std::atomic<Ring*> m_ring;
+        std::vector<std::unique_ptr<Ring>> m_rings;
+        char m_pad_2[detail::CACHE_LINE_SIZE];
+
+        Ring* grow(Ring* ring, std::int64_t bottom, std::int64_t top) {
+            std::unique_ptr<Ring> bigger(new Ring(ring->capacity() * 2));
+            for (std::int64_t i = top; i < bottom; ++i) {
+                bigger->put(i, ring->get(i));
+            }
+            Ring* result = bigger.get();
+            m_rings.push_back(std::move(bigger));
+            m_ring.store(result, std::memory_order_release);
+            return result;
+        }
+
+        bool push_back(Stored object) {
+            const std::int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+            const std::int64_t top = m_top.load(std::memory_order_acquire);
+            Ring* ring = m_ring.load(std::memory_order_relaxed);
+            if (bottom - top > ring->mask) {
+                ring = grow(ring, bottom, top);
+            }
+            ring->put(bottom, object);
+            std::atomic_thread_fence(std::memory_order_release);
+            m_bottom.store(bottom + 1, std::memory_order_relaxed);
+            return true;
+        }
+
+      public:
+        /**
+         * Constructs an empty deque.
+         * @param[in] capacity The number of objects the deque can hold before it first has to grow. It is rounded up
+         * to the next power of two.
+         */
+        explicit WorkStealingDeque(std::size_t capacity = 64) : m_top(0), m_bottom(0) {
+            m_rings.emplace_back(new Ring(static_cast<std::int64_t>(detail::round_up_to_power_of_two(capacity))));
+            m_ring.store(m_rings.back().get(), std::memory_order_relaxed);
+        }
+
+        WorkStealingDeque(const WorkStealingDeque&) = delete;
+        WorkStealingDeque& operator=(const WorkStealingDeque&) = delete;
+
+        ~WorkStealingDeque() {
+            Ring* ring = m_ring.load(std::memory_order_relaxed);
+            const std::int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+            for (std::int64_t i = m_top.load(std::memory_order_relaxed); i < bottom; ++i) {
+                Slot::destroy(ring->get(i));
+            }
+        }
+
+        /**
+         * Pushes the given object to the bottom of the deque. Must only be called from the owner thread.
+         * @param[in] data The const lvalue reference to be pushed to the deque.
+         * @return true if an object was successfully pushed to the deque, otherwise false.
+         */
+        bool push(const T& data) { return push_back(Slot::store(data)); }
+
+        /**
+         * Pushes the given object to the bottom of the deque. Must only be called from the owner thread.
+         * @param[in] data The rvalue reference to be pushed to the deque.
+         * @return true if an object was successfully pushed to the deque, otherwise false.
+         */
+        bool push(T&& data) { return push_back(Slot::store(std::move(data))); }
+
+        /**
+         * Pushes a new object to the bottom of the deque. The object is constructed in-place. Must only be called from
+         * the owner thread.
+         * @param[in] args The arguments to forward to the constructor of the object.
+         * @return true if an object was successfully emplaced in the deque, otherwise false.
+         */
+        template <typename... Args>
+        bool emplace(Args&&... args) {
+            return push_back(Slot::store(std::forward<Args>(args)...));
+        }
+
+        /**
+         * Pops the most recently pushed object from the bottom of the deque without blocking. This function will
+         * return immediately if the deque is empty. Must only be called from the owner thread.
+         * @param[out] data A reference to where the popped object will be stored.
+         * @return true if an object was popped from the bottom of the deque, otherwise false.
+         */
+        bool pop(T& data) {
+            const std::int64_t bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+            Ring* ring = m_ring.load(std::memory_order_relaxed);
+            m_bottom.store(bottom, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            std::int64_t top = m_top.load(std::memory_order_relaxed);
+            if (top > bottom) {
+                m_bottom.store(bottom + 1, std::memory_order_relaxed);
+                return false;
+            }
+            Stored object = ring->get(bottom);
+            if (top == bottom) {
+                // This is the last object, so a thief may be trying to take it as well.
+                bool won = m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst,
+                                                         std::memory_order_relaxed);
+                m_bottom.store(bottom + 1, std::memory_order_relaxed);
+                if (!won) {
+                    return false;
+                }
+            }
+            Slot::take(object, data);
+            return true;
+        }
+
+        /**
+         * Steals the least recently pushed object from the top of the deque without blocking. This function will
+         * return immediately if the deque is empty. May be called from any thread.
+         * @param[out] data A reference to where the stolen object will be stored.
+         * @return true if an object was stolen from the top of the deque, otherwise false.
+         */
+        bool steal(T& data) {
+            for (;;) {
+                std::int64_t top = m_top.load(std::memory_order_acquire);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                const std::int64_t bottom = m_bottom.load(std::memory_order_acquire);
+                if (top >= bottom) {
+                    return false;
+                }
+                Stored object = m_ring.load(std::memory_order_acquire)->get(top);
+                if (m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst,
+                                                  std::memory_order_relaxed)) {
+                    Slot::take(object, data);
+                    return true;
+                }
+            }
+        }
+    };
+}
+
+#endif
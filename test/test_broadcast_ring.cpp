@@ -0,0 +1,204 @@
+/*
+ * test_broadcast_ring.cpp - Test code for the mpmcplusplus broadcast ring
+ * Copyright (C) 2021 James Triantafylos
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "doctest/doctest.h"
+
+#include <memory>
+#include <thread>
+
+#include "mpmcplusplus/broadcast_ring.h"
+
+TEST_SUITE("broadcast ring") {
+    TEST_CASE("creating a broadcast ring") {
+        mpmcplusplus::BroadcastRing<int> r(10);
+
+        CHECK(r.capacity() == 16);
+    }
+
+    TEST_CASE("popping from empty broadcast ring") {
+        mpmcplusplus::BroadcastRing<int> r(16);
+        mpmcplusplus::BroadcastRing<int>::Subscriber s(r);
+
+        int result;
+        CHECK_FALSE(s.pop(result));
+    }
+
+    TEST_CASE("every subscriber reads every object") {
+        mpmcplusplus::BroadcastRing<int> r(16);
+        mpmcplusplus::BroadcastRing<int>::Subscriber s1(r);
+        mpmcplusplus::BroadcastRing<int>::Subscriber s2(r);
+
+        for (int i = 0; i < 10; ++i) {
+            REQUIRE(r.push(i));
+        }
+
+        int result;
+        for (int i = 0; i < 10; ++i) {
+            REQUIRE(s1.pop(result));
+            REQUIRE(result == i);
+        }
+        CHECK_FALSE(s1.pop(result));
+        for (int i = 0; i < 10; ++i) {
+            REQUIRE(s2.pop(result));
+            REQUIRE(result == i);
+        }
+        CHECK_FALSE(s2.pop(result));
+    }
+
+    TEST_CASE("subscribers start with the next pushed object") {
+        mpmcplusplus::BroadcastRing<int> r(16);
+        REQUIRE(r.push(1));
+
+        mpmcplusplus::BroadcastRing<int>::Subscriber s(r);
+        int result;
+        CHECK_FALSE(s.pop(result));
+        REQUIRE(r.push(2));
+        REQUIRE(s.pop(result));
+        CHECK(result == 2);
+    }
+
+    TEST_CASE("pushing without subscribers never fills the ring") {
+        mpmcplusplus::BroadcastRing<int> r(4);
+
+        for (int i = 0; i < 100; ++i) {
+            REQUIRE(r.push(i));
+        }
+    }
+
+    TEST_CASE("a slow subscriber blocks the producer") {
+        mpmcplusplus::BroadcastRing<int> r(4);
+        mpmcplusplus::BroadcastRing<int>::Subscriber fast(r);
+        mpmcplusplus::BroadcastRing<int>::Subscriber slow(r);
+
+        int result;
+        for (int i = 0; i < 4; ++i) {
+            REQUIRE(r.push(i));
+            REQUIRE(fast.pop(result));
+        }
+        REQUIRE_FALSE(r.push(4));
+
+        REQUIRE(slow.pop(result));
+        CHECK(result == 0);
+        REQUIRE(r.push(4));
+        CHECK_FALSE(r.push(5));
+        CHECK_FALSE(slow.dropped());
+    }
+
+    TEST_CASE("a slow subscriber is dropped") {
+        mpmcplusplus::BroadcastRing<int> r(4, mpmcplusplus::SlowSubscriberPolicy::DROP_SUBSCRIBER);
+        mpmcplusplus::BroadcastRing<int>::Subscriber fast(r);
+        mpmcplusplus::BroadcastRing<int>::Subscriber slow(r);
+
+        int result;
+        REQUIRE(r.push(0));
+        REQUIRE(fast.pop(result));
+        REQUIRE(slow.pop(result));
+        for (int i = 1; i < 100; ++i) {
+            REQUIRE(r.push(i));
+            REQUIRE(fast.pop(result));
+            REQUIRE(result == i);
+        }
+
+        CHECK(slow.dropped());
+        CHECK_FALSE(slow.pop(result));
+        CHECK_FALSE(slow.wait_and_pop(result));
+        CHECK_FALSE(fast.dropped());
+    }
+
+    TEST_CASE("destroying a broadcast ring destroys the remaining objects") {
+        std::shared_ptr<int> val = std::make_shared<int>(10);
+        {
+            mpmcplusplus::BroadcastRing<std::shared_ptr<int>> r(4);
+            for (int i = 0; i < 10; ++i) {
+                REQUIRE(r.push(val));
+            }
+            REQUIRE(val.use_count() == 5);
+        }
+        CHECK(val.use_count() == 1);
+    }
+
+    TEST_CASE("popping from empty broadcast ring with waiting and timeout") {
+        mpmcplusplus::BroadcastRing<int> r(16);
+        mpmcplusplus::BroadcastRing<int>::Subscriber s(r);
+        std::chrono::milliseconds duration(10);
+
+        int result;
+        REQUIRE_FALSE(s.wait_and_pop(result, duration));
+        CHECK_FALSE(s.pop(result));
+    }
+
+    TEST_CASE("single producer multi subscriber concurrently pushing and popping with waiting") {
+        mpmcplusplus::BroadcastRing<int> r(64);
+        mpmcplusplus::BroadcastRing<int>::Subscriber s1(r);
+        mpmcplusplus::BroadcastRing<int>::Subscriber s2(r);
+        mpmcplusplus::BroadcastRing<int>::Subscriber s3(r);
+
+        auto pop = [](mpmcplusplus::BroadcastRing<int>::Subscriber* s) {
+            int result;
+            for (int i = 0; i < 30000; ++i) {
+                REQUIRE(s->wait_and_pop(result));
+                REQUIRE(result == i);
+            }
+            REQUIRE_FALSE(s->pop(result));
+        };
+
+        std::thread pop_thread_1(pop, &s1);
+        std::thread pop_thread_2(pop, &s2);
+        std::thread pop_thread_3(pop, &s3);
+        std::thread push_thread([&r]() {
+            for (int i = 0; i < 30000; ++i) {
+                REQUIRE(r.wait_and_push(i));
+            }
+        });
+
+        pop_thread_1.join();
+        pop_thread_2.join();
+        pop_thread_3.join();
+        push_thread.join();
+    }
+
+    TEST_CASE("dropping subscribers while they read concurrently") {
+        mpmcplusplus::BroadcastRing<std::shared_ptr<int>> r(8, mpmcplusplus::SlowSubscriberPolicy::DROP_SUBSCRIBER);
+        mpmcplusplus::BroadcastRing<std::shared_ptr<int>>::Subscriber s1(r);
+        mpmcplusplus::BroadcastRing<std::shared_ptr<int>>::Subscriber s2(r);
+
+        auto pop = [](mpmcplusplus::BroadcastRing<std::shared_ptr<int>>::Subscriber* s) {
+            std::shared_ptr<int> result;
+            int previous = -1;
+            while (s->wait_and_pop(result)) {
+                REQUIRE(*result > previous);
+                previous = *result;
+                if (previous == 29999) {
+                    break;
+                }
+            }
+        };
+
+        std::thread pop_thread_1(pop, &s1);
+        std::thread pop_thread_2(pop, &s2);
+        std::thread push_thread([&r]() {
+            for (int i = 0; i < 30000; ++i) {
+                REQUIRE(r.push(std::make_shared<int>(i)));
+            }
+        });
+
+        push_thread.join();
+        pop_thread_1.join();
+        pop_thread_2.join();
+    }
+}
@@ -0,0 +1,232 @@
+/*
+ * test_byte_ring.cpp - Test code for the mpmcplusplus byte message ring
+ * Copyright (C) 2021 James Triantafylos
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "doctest/doctest.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <thread>
+
+#include "mpmcplusplus/byte_ring.h"
+
+TEST_SUITE("byte ring") {
+    TEST_CASE("creating a byte ring") {
+        mpmcplusplus::ByteRing r(100);
+
+        CHECK(r.capacity() == 128);
+    }
+
+    TEST_CASE("reading from empty byte ring") {
+        mpmcplusplus::ByteRing r(64);
+
+        const std::uint8_t* data;
+        std::size_t size;
+        CHECK_FALSE(r.read(data, size));
+    }
+
+    TEST_CASE("reading from empty byte ring with waiting and timeout") {
+        mpmcplusplus::ByteRing r(64);
+        std::chrono::milliseconds duration(10);
+
+        const std::uint8_t* data;
+        std::size_t size;
+        REQUIRE_FALSE(r.wait_and_read(data, size, duration));
+        CHECK_FALSE(r.read(data, size));
+    }
+
+    TEST_CASE("reserving, committing and reading a message in place") {
+        mpmcplusplus::ByteRing r(64);
+
+        std::uint8_t* region = r.reserve(5);
+        REQUIRE(region != nullptr);
+        CHECK(reinterpret_cast<std::uintptr_t>(region) % 8 == 0);
+        std::memcpy(region, "hello", 5);
+
+        const std::uint8_t* data;
+        std::size_t size;
+        CHECK_FALSE(r.read(data, size));
+        r.commit(region);
+        REQUIRE(r.read(data, size));
+        CHECK(data == region);
+        CHECK(std::string(reinterpret_cast<const char*>(data), size) == "hello");
+        r.release();
+        CHECK_FALSE(r.read(data, size));
+    }
+
+    TEST_CASE("pushing empty messages") {
+        mpmcplusplus::ByteRing r(16);
+
+        REQUIRE(r.push("", 0));
+        REQUIRE(r.push("", 0));
+        CHECK_FALSE(r.push("", 0));
+
+        const std::uint8_t* data;
+        std::size_t size;
+        REQUIRE(r.read(data, size));
+        CHECK(size == 0);
+        r.release();
+        REQUIRE(r.read(data, size));
+        CHECK(size == 0);
+        r.release();
+        CHECK_FALSE(r.read(data, size));
+    }
+
+    TEST_CASE("pushing to a full byte ring") {
+        mpmcplusplus::ByteRing r(64);
+        const char payload[65] = {};
+
+        CHECK_FALSE(r.push(payload, 65));
+        REQUIRE(r.reserve(64) != nullptr);
+        CHECK(r.reserve(1) == nullptr);
+    }
+
+    TEST_CASE("messages that would wrap are placed at the start of the ring") {
+        mpmcplusplus::ByteRing r(64);
+        const char payload[40] = "wraps around";
+
+        REQUIRE(r.push(payload, 40));
+        const std::uint8_t* data;
+        std::size_t size;
+        REQUIRE(r.read(data, size));
+        const std::uint8_t* first = data;
+        r.release();
+
+        // 40 bytes are used from offset 40 but only 24 remain before the end, so the message must skip them.
+        REQUIRE(r.push(payload, 40));
+        REQUIRE(r.read(data, size));
+        CHECK(data == first);
+        CHECK(size == 40);
+        CHECK(std::strcmp(reinterpret_cast<const char*>(data), "wraps around") == 0);
+        r.release();
+        CHECK_FALSE(r.read(data, size));
+    }
+
+    TEST_CASE("a message of the full capacity fits an empty ring wherever the tail stands") {
+        mpmcplusplus::ByteRing r(64);
+        const char payload[64] = "full capacity";
+
+        REQUIRE(r.push(payload, 8));
+        const std::uint8_t* data;
+        std::size_t size;
+        REQUIRE(r.read(data, size));
+        const std::uint8_t* first = data;
+        r.release();
+
+        for (int i = 0; i < 3; ++i) {
+            REQUIRE(r.push(payload, r.capacity()));
+            CHECK_FALSE(r.push(payload, 1));
+            REQUIRE(r.read(data, size));
+            CHECK(data == first);
+            CHECK(size == r.capacity());
+            CHECK(std::strcmp(reinterpret_cast<const char*>(data), "full capacity") == 0);
+            r.release();
+            CHECK_FALSE(r.read(data, size));
+            REQUIRE(r.push(payload, 8));
+            REQUIRE(r.read(data, size));
+            r.release();
+        }
+    }
+
+    TEST_CASE("a message that would wrap does not fit until the start is free") {
+        mpmcplusplus::ByteRing r(64);
+        const char payload[32] = {};
+
+        REQUIRE(r.push(payload, 24));
+        REQUIRE(r.push(payload, 24));
+        const std::uint8_t* data;
+        std::size_t size;
+        REQUIRE(r.read(data, size));
+        r.release();
+
+        // 40 free bytes in total, but only 16 at the end and 24 at the start.
+        CHECK_FALSE(r.push(payload, 32));
+        REQUIRE(r.push(payload, 24));
+    }
+
+    TEST_CASE("messages committed out of order are read in reservation order") {
+        mpmcplusplus::ByteRing r(64);
+
+        std::uint8_t* first = r.reserve(1);
+        std::uint8_t* second = r.reserve(1);
+        REQUIRE(first != nullptr);
+        REQUIRE(second != nullptr);
+        *first = 1;
+        *second = 2;
+        r.commit(second);
+
+        const std::uint8_t* data;
+        std::size_t size;
+        CHECK_FALSE(r.read(data, size));
+        r.commit(first);
+        REQUIRE(r.read(data, size));
+        CHECK(*data == 1);
+        r.release();
+        REQUIRE(r.read(data, size));
+        CHECK(*data == 2);
+        r.release();
+    }
+
+    TEST_CASE("multi producer single consumer concurrently pushing variable-length messages with waiting") {
+        mpmcplusplus::ByteRing r(1024);
+
+        auto push = [&r](std::uint8_t producer) {
+            for (std::uint32_t i = 0; i < 10000; ++i) {
+                const std::size_t size = 1 + (i % 50);
+                std::uint8_t* region;
+                while ((region = r.reserve(size)) == nullptr) {
+                    std::this_thread::yield();
+                }
+                region[0] = producer;
+                for (std::size_t j = 1; j < size; ++j) {
+                    region[j] = static_cast<std::uint8_t>(i);
+                }
+                r.commit(region);
+            }
+        };
+
+        std::thread push_thread_1(push, 0);
+        std::thread push_thread_2(push, 1);
+        std::thread push_thread_3(push, 2);
+
+        std::uint32_t expected[3] = {0, 0, 0};
+        const std::uint8_t* data;
+        std::size_t size;
+        for (int i = 0; i < 30000; ++i) {
+            REQUIRE(r.wait_and_read(data, size));
+            REQUIRE(data[0] < 3);
+            std::uint32_t& next = expected[data[0]];
+            REQUIRE(size == 1 + (next % 50));
+            for (std::size_t j = 1; j < size; ++j) {
+                REQUIRE(data[j] == static_cast<std::uint8_t>(next));
+            }
+            ++next;
+            r.release();
+        }
+
+        push_thread_1.join();
+        push_thread_2.join();
+        push_thread_3.join();
+
+        CHECK(expected[0] == 10000);
+        CHECK(expected[1] == 10000);
+        CHECK(expected[2] == 10000);
+        CHECK_FALSE(r.read(data, size));
+    }
+}
@@ -0,0 +1,193 @@
+/*
+ * test_conflating_queue.cpp - Test code for the mpmcplusplus conflating queue
+ * Copyright (C) 2021 James Triantafylos
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "doctest/doctest.h"
+
+#include <atomic>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include "mpmcplusplus/conflating_queue.h"
+
+namespace {
+    struct Checked {
+        int value;
+
+        explicit Checked(int value = 0) : value(value) {}
+        Checked(const Checked&) = default;
+
+        Checked& operator=(const Checked& other) {
+            if (other.value < 0) {
+                throw std::invalid_argument("negative value");
+            }
+            value = other.value;
+            return *this;
+        }
+    };
+}
+
+TEST_SUITE("conflating queue") {
+    TEST_CASE("creating a conflating queue") { mpmcplusplus::ConflatingQueue<int, int> q; }
+
+    TEST_CASE("popping from empty conflating queue") {
+        mpmcplusplus::ConflatingQueue<int, int> q;
+
+        int key;
+        int value;
+        CHECK_FALSE(q.pop(key, value));
+    }
+
+    TEST_CASE("pushing and popping distinct keys in order") {
+        mpmcplusplus::ConflatingQueue<int, int> q;
+
+        for (int i = 0; i < 10000; ++i) {
+            REQUIRE(q.push(i, i * 2));
+        }
+        CHECK(q.size() == 10000);
+
+        int key;
+        int value;
+        for (int i = 0; i < 10000; ++i) {
+            REQUIRE(q.pop(key, value));
+            REQUIRE(key == i);
+            REQUIRE(value == i * 2);
+        }
+        CHECK_FALSE(q.pop(key, value));
+    }
+
+    TEST_CASE("pushing a pending key replaces its value and keeps its position") {
+        mpmcplusplus::ConflatingQueue<std::string, int> q;
+
+        REQUIRE(q.push("a", 1));
+        REQUIRE(q.push("b", 2));
+        REQUIRE(q.push("a", 3));
+        REQUIRE(q.push("c", 4));
+        REQUIRE(q.push("b", 5));
+        CHECK(q.size() == 3);
+
+        std::string key;
+        int value;
+        REQUIRE(q.pop(key, value));
+        CHECK(key == "a");
+        CHECK(value == 3);
+        REQUIRE(q.pop(key, value));
+        CHECK(key == "b");
+        CHECK(value == 5);
+        REQUIRE(q.pop(key, value));
+        CHECK(key == "c");
+        CHECK(value == 4);
+        CHECK_FALSE(q.pop(key, value));
+    }
+
+    TEST_CASE("pushing a popped key queues it again at the back") {
+        mpmcplusplus::ConflatingQueue<int, int> q;
+
+        REQUIRE(q.push(1, 10));
+        REQUIRE(q.push(2, 20));
+
+        int key;
+        int value;
+        REQUIRE(q.pop(key, value));
+        REQUIRE(key == 1);
+        REQUIRE(q.push(1, 11));
+
+        REQUIRE(q.pop(key, value));
+        CHECK(key == 2);
+        REQUIRE(q.pop(key, value));
+        CHECK(key == 1);
+        CHECK(value == 11);
+    }
+
+    TEST_CASE("a value that throws while being popped stays pending under its key") {
+        mpmcplusplus::ConflatingQueue<std::string, Checked> q;
+
+        REQUIRE(q.push("pending key", Checked(-1)));
+
+        std::string key;
+        Checked value;
+        CHECK_THROWS_AS(q.pop(key, value), std::invalid_argument);
+        CHECK(q.size() == 1);
+
+        REQUIRE(q.push("pending key", Checked(1)));
+        REQUIRE(q.pop(key, value));
+        CHECK(key == "pending key");
+        CHECK(value.value == 1);
+        CHECK(q.size() == 0);
+    }
+
+    TEST_CASE("popping from empty conflating queue with waiting and timeout") {
+        mpmcplusplus::ConflatingQueue<int, int> q;
+        std::chrono::milliseconds duration(10);
+
+        int key;
+        int value;
+        REQUIRE_FALSE(q.wait_and_pop(key, value, duration));
+        CHECK_FALSE(q.pop(key, value));
+    }
+
+    TEST_CASE("multi producer multi consumer concurrently pushing and popping with waiting") {
+        mpmcplusplus::ConflatingQueue<int, int> q;
+        std::atomic<bool> done(false);
+        std::atomic<int> last_values[3];
+        for (std::atomic<int>& last_value : last_values) {
+            last_value = -1;
+        }
+
+        auto pop = [&q, &done, &last_values]() {
+            int key;
+            int value;
+            std::chrono::milliseconds duration(10);
+            while (!done || q.size() > 0) {
+                if (q.wait_and_pop(key, value, duration)) {
+                    REQUIRE((key >= 0 && key < 3));
+                    int previous = last_values[key].load();
+                    while (previous < value && !last_values[key].compare_exchange_weak(previous, value)) {
+                    }
+                }
+            }
+        };
+
+        auto push = [&q](int key) {
+            for (int i = 0; i < 10000; ++i) {
+                REQUIRE(q.push(key, i));
+                REQUIRE(q.size() <= 3);
+            }
+        };
+
+        std::thread pop_thread_1(pop);
+        std::thread pop_thread_2(pop);
+        std::thread push_thread_1(push, 0);
+        std::thread push_thread_2(push, 1);
+        std::thread push_thread_3(push, 2);
+
+        push_thread_1.join();
+        push_thread_2.join();
+        push_thread_3.join();
+        done = true;
+        pop_thread_1.join();
+        pop_thread_2.join();
+
+        for (std::atomic<int>& last_value : last_values) {
+            CHECK(last_value == 9999);
+        }
+        int key;
+        int value;
+        CHECK_FALSE(q.pop(key, value));
+    }
+}
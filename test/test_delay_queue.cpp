@@ -0,0 +1,202 @@
+/*
+ * test_delay_queue.cpp - Test code for the mpmcplusplus delay queue
+ * Copyright (C) 2021 James Triantafylos
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "doctest/doctest.h"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+
+#include "mpmcplusplus/delay_queue.h"
+
+typedef mpmcplusplus::DelayQueue<int>::Clock Clock;
+
+TEST_SUITE("delay queue") {
+    TEST_CASE("creating a delay queue") { mpmcplusplus::DelayQueue<int> q; }
+
+    TEST_CASE("popping from empty delay queue") {
+        mpmcplusplus::DelayQueue<int> q;
+
+        int result;
+        CHECK_FALSE(q.pop(result));
+    }
+
+    TEST_CASE("pushing and popping one value that is already due") {
+        mpmcplusplus::DelayQueue<int> q;
+        const int val = 10;
+
+        REQUIRE(q.push(val, Clock::now()));
+
+        int result;
+        REQUIRE(q.pop(result));
+        CHECK(result == val);
+        CHECK_FALSE(q.pop(result));
+    }
+
+    TEST_CASE("popping a value before its deadline") {
+        mpmcplusplus::DelayQueue<int> q;
+
+        REQUIRE(q.push(10, Clock::now() + std::chrono::hours(1)));
+
+        int result;
+        CHECK_FALSE(q.pop(result));
+        CHECK_FALSE(q.wait_and_pop(result, std::chrono::milliseconds(10)));
+    }
+
+    TEST_CASE("waiting for a value returns no earlier than its deadline") {
+        mpmcplusplus::DelayQueue<std::unique_ptr<int>> q;
+        const Clock::time_point deadline = Clock::now() + std::chrono::milliseconds(20);
+
+        REQUIRE(q.emplace(deadline, new int(10)));
+
+        std::unique_ptr<int> result;
+        REQUIRE(q.wait_and_pop(result));
+        CHECK(Clock::now() >= deadline);
+        CHECK(*result == 10);
+        CHECK_FALSE(q.pop(result));
+    }
+
+    TEST_CASE("values come out in deadline order across every level of the wheel") {
+        mpmcplusplus::DelayQueue<int> q(std::chrono::microseconds(1));
+        const Clock::time_point start = Clock::now() + std::chrono::milliseconds(50);
+
+        // Spread deadlines over 100ms in a scrambled order so that they land on the first three levels. They start
+        // far enough in the future that none of them is already due while the rest are still being pushed.
+        for (int i = 0; i < 500; ++i) {
+            int slot = (i * 313) % 500;
+            REQUIRE(q.push(slot, start + std::chrono::microseconds(200 * slot)));
+        }
+
+        int result;
+        for (int i = 0; i < 500; ++i) {
+            REQUIRE(q.wait_and_pop(result));
+            REQUIRE(result == i);
+            REQUIRE(Clock::now() >= start + std::chrono::microseconds(200 * i));
+        }
+        CHECK_FALSE(q.pop(result));
+    }
+
+    TEST_CASE("values beyond the top level of a fine-grained wheel come out in deadline order after idling") {
+        mpmcplusplus::DelayQueue<int> q(std::chrono::nanoseconds(1));
+        const Clock::time_point start = Clock::now() + std::chrono::milliseconds(5);
+
+        // With 1ns ticks the four levels span about 16ms, so the later deadlines start out in the overflow list and
+        // the wheel has to jump over long stretches of idle ticks to reach them.
+        const int order[] = {3, 0, 4, 1, 2};
+        for (int i : order) {
+            REQUIRE(q.push(i, start + std::chrono::milliseconds(10 * i)));
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(30));
+
+        int result;
+        for (int i = 0; i < 5; ++i) {
+            REQUIRE(q.wait_and_pop(result));
+            REQUIRE(result == i);
+            REQUIRE(Clock::now() >= start + std::chrono::milliseconds(10 * i));
+        }
+        CHECK_FALSE(q.pop(result));
+    }
+
+    TEST_CASE("values that expire together wake every waiting consumer") {
+        mpmcplusplus::DelayQueue<int> q;
+        std::atomic<int> popped_sum(0);
+
+        auto pop = [&q, &popped_sum]() {
+            int result;
+            REQUIRE(q.wait_and_pop(result));
+            popped_sum.fetch_add(result);
+        };
+
+        std::thread pop_thread_1(pop);
+        std::thread pop_thread_2(pop);
+        std::thread pop_thread_3(pop);
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        const Clock::time_point deadline = Clock::now() + std::chrono::milliseconds(20);
+        REQUIRE(q.push(1, deadline));
+        REQUIRE(q.push(2, deadline));
+        REQUIRE(q.push(3, deadline));
+
+        pop_thread_1.join();
+        pop_thread_2.join();
+        pop_thread_3.join();
+
+        CHECK(popped_sum == 6);
+        int result;
+        CHECK_FALSE(q.pop(result));
+    }
+
+    TEST_CASE("an earlier push wakes a consumer waiting for a later deadline") {
+        mpmcplusplus::DelayQueue<int> q;
+
+        REQUIRE(q.push(2, Clock::now() + std::chrono::hours(1)));
+
+        std::thread pop_thread([&q]() {
+            int result;
+            REQUIRE(q.wait_and_pop(result, std::chrono::seconds(10)));
+            REQUIRE(result == 1);
+        });
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        REQUIRE(q.push(1, Clock::now() + std::chrono::milliseconds(10)));
+        pop_thread.join();
+
+        int result;
+        CHECK_FALSE(q.pop(result));
+    }
+
+    TEST_CASE("multi consumer multi producer concurrently pushing and popping with waiting") {
+        mpmcplusplus::DelayQueue<int> q(std::chrono::microseconds(100));
+        std::atomic<int> popped_count(0);
+        std::atomic<int> popped_sum(0);
+
+        auto pop = [&q, &popped_count, &popped_sum]() {
+            int result;
+            while (popped_count.fetch_add(1) < 3000) {
+                REQUIRE(q.wait_and_pop(result));
+                REQUIRE((result == 1 || result == 2 || result == 3));
+                popped_sum.fetch_add(result);
+            }
+        };
+
+        auto push = [&q](int val) {
+            for (int i = 0; i < 1000; ++i) {
+                REQUIRE(q.push(val, Clock::now() + std::chrono::microseconds((i % 50) * 100)));
+            }
+        };
+
+        std::thread pop_thread_1(pop);
+        std::thread pop_thread_2(pop);
+        std::thread pop_thread_3(pop);
+        std::thread push_thread_1(push, 1);
+        std::thread push_thread_2(push, 2);
+        std::thread push_thread_3(push, 3);
+
+        pop_thread_1.join();
+        pop_thread_2.join();
+        pop_thread_3.join();
+        push_thread_1.join();
+        push_thread_2.join();
+        push_thread_3.join();
+
+        CHECK(popped_sum == 6000);
+        int result;
+        CHECK_FALSE(q.pop(result));
+    }
+}
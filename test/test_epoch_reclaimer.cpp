@@ -0,0 +1,100 @@
+/*
+ * test_epoch_reclaimer.cpp - Test code for the mpmcplusplus epoch-based reclaimer
+ * Copyright (C) 2021 James Triantafylos
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "doctest/doctest.h"
+
+#include <atomic>
+#include <thread>
+
+#include "mpmcplusplus/epoch_reclaimer.h"
+
+namespace {
+    struct Counted {
+        std::atomic<int>& destroyed;
+
+        explicit Counted(std::atomic<int>& destroyed) : destroyed(destroyed) {}
+        ~Counted() { destroyed.fetch_add(1); }
+    };
+}
+
+TEST_SUITE("epoch reclaimer") {
+    TEST_CASE("creating an epoch reclaimer") { mpmcplusplus::EpochReclaimer reclaimer; }
+
+    TEST_CASE("retired objects are deleted in batches") {
+        const int batch = mpmcplusplus::EpochReclaimer::RETIRE_BATCH_SIZE;
+        std::atomic<int> destroyed(0);
+        mpmcplusplus::EpochReclaimer reclaimer;
+
+        for (int i = 0; i < batch - 1; ++i) {
+            mpmcplusplus::EpochReclaimer::Guard guard(reclaimer);
+            guard.retire(new Counted(destroyed));
+        }
+        CHECK(destroyed == 0);
+
+        for (int i = 0; i < batch * 3; ++i) {
+            mpmcplusplus::EpochReclaimer::Guard guard(reclaimer);
+            guard.retire(new Counted(destroyed));
+        }
+        CHECK(destroyed > 0);
+    }
+
+    TEST_CASE("an active guard holds back deletion") {
+        const int batch = mpmcplusplus::EpochReclaimer::RETIRE_BATCH_SIZE;
+        std::atomic<int> destroyed(0);
+        std::atomic<bool> pinned(false);
+        std::atomic<bool> release(false);
+        mpmcplusplus::EpochReclaimer reclaimer;
+
+        std::thread reader([&reclaimer, &pinned, &release]() {
+            mpmcplusplus::EpochReclaimer::Guard guard(reclaimer);
+            pinned = true;
+            while (!release) {
+                std::this_thread::yield();
+            }
+        });
+        while (!pinned) {
+            std::this_thread::yield();
+        }
+
+        for (int i = 0; i < batch * 4; ++i) {
+            mpmcplusplus::EpochReclaimer::Guard guard(reclaimer);
+            guard.retire(new Counted(destroyed));
+        }
+        CHECK(destroyed == 0);
+
+        release = true;
+        reader.join();
+        for (int i = 0; i < batch * 3; ++i) {
+            mpmcplusplus::EpochReclaimer::Guard guard(reclaimer);
+            guard.retire(new Counted(destroyed));
+        }
+        CHECK(destroyed > 0);
+    }
+
+    TEST_CASE("destroying an epoch reclaimer deletes every retired object") {
+        std::atomic<int> destroyed(0);
+        {
+            mpmcplusplus::EpochReclaimer reclaimer;
+            for (int i = 0; i < 10; ++i) {
+                mpmcplusplus::EpochReclaimer::Guard guard(reclaimer);
+                guard.retire(new Counted(destroyed));
+            }
+        }
+        CHECK(destroyed == 10);
+    }
+}
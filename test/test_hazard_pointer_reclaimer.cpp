@@ -0,0 +1,103 @@
+/*
+ * test_hazard_pointer_reclaimer.cpp - Test code for the mpmcplusplus hazard pointer reclaimer
+ * Copyright (C) 2021 James Triantafylos
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "doctest/doctest.h"
+
+#include <atomic>
+#include <thread>
+
+#include "mpmcplusplus/hazard_pointer_reclaimer.h"
+
+namespace {
+    struct Counted {
+        std::atomic<int>& destroyed;
+
+        explicit Counted(std::atomic<int>& destroyed) : destroyed(destroyed) {}
+        ~Counted() { destroyed.fetch_add(1); }
+    };
+}
+
+TEST_SUITE("hazard pointer reclaimer") {
+    TEST_CASE("creating a hazard pointer reclaimer") { mpmcplusplus::HazardPointerReclaimer reclaimer; }
+
+    TEST_CASE("retired objects are deleted in batches") {
+        const int batch = mpmcplusplus::HazardPointerReclaimer::RETIRE_BATCH_SIZE;
+        std::atomic<int> destroyed(0);
+        mpmcplusplus::HazardPointerReclaimer reclaimer;
+
+        for (int i = 0; i < batch - 1; ++i) {
+            mpmcplusplus::HazardPointerReclaimer::Guard guard(reclaimer);
+            guard.retire(new Counted(destroyed));
+        }
+        CHECK(destroyed == 0);
+
+        mpmcplusplus::HazardPointerReclaimer::Guard guard(reclaimer);
+        guard.retire(new Counted(destroyed));
+        CHECK(destroyed == batch);
+    }
+
+    TEST_CASE("a stalled guard only holds back the object it protects") {
+        const int batch = mpmcplusplus::HazardPointerReclaimer::RETIRE_BATCH_SIZE;
+        std::atomic<int> destroyed(0);
+        std::atomic<int> shared_destroyed(0);
+        std::atomic<Counted*> shared(new Counted(shared_destroyed));
+        std::atomic<bool> protecting(false);
+        std::atomic<bool> release(false);
+        mpmcplusplus::HazardPointerReclaimer reclaimer;
+
+        std::thread reader([&reclaimer, &shared, &protecting, &release]() {
+            mpmcplusplus::HazardPointerReclaimer::Guard guard(reclaimer);
+            Counted* object = guard.protect(0, shared);
+            protecting = true;
+            while (!release) {
+                std::this_thread::yield();
+            }
+            CHECK(object != nullptr);
+        });
+        while (!protecting) {
+            std::this_thread::yield();
+        }
+
+        {
+            mpmcplusplus::HazardPointerReclaimer::Guard guard(reclaimer);
+            guard.retire(shared.exchange(nullptr));
+        }
+        for (int i = 0; i < batch * 10; ++i) {
+            mpmcplusplus::HazardPointerReclaimer::Guard guard(reclaimer);
+            guard.retire(new Counted(destroyed));
+        }
+        CHECK(destroyed >= batch * 9);
+        CHECK(shared_destroyed == 0);
+
+        release = true;
+        reader.join();
+        CHECK(shared_destroyed == 0);
+    }
+
+    TEST_CASE("destroying a hazard pointer reclaimer deletes every retired object") {
+        std::atomic<int> destroyed(0);
+        {
+            mpmcplusplus::HazardPointerReclaimer reclaimer;
+            for (int i = 0; i < 10; ++i) {
+                mpmcplusplus::HazardPointerReclaimer::Guard guard(reclaimer);
+                guard.retire(new Counted(destroyed));
+            }
+        }
+        CHECK(destroyed == 10);
+    }
+}
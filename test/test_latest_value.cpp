@@ -0,0 +1,128 @@
+/*
+ * test_latest_value.cpp - Test code for the mpmcplusplus latest value slot
+ * Copyright (C) 2021 James Triantafylos
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "doctest/doctest.h"
+
+#include <memory>
+#include <thread>
+
+#include "mpmcplusplus/latest_value.h"
+
+namespace {
+    struct NotDefaultConstructible {
+        int value;
+
+        explicit NotDefaultConstructible(int value) : value(value) {}
+    };
+}
+
+TEST_SUITE("latest value") {
+    TEST_CASE("creating a latest value mailbox") { mpmcplusplus::LatestValue<int> m; }
+
+    TEST_CASE("popping from empty latest value mailbox") {
+        mpmcplusplus::LatestValue<int> m;
+
+        int result;
+        CHECK_FALSE(m.pop(result));
+    }
+
+    TEST_CASE("pushing and popping one lvalue") {
+        mpmcplusplus::LatestValue<int> m;
+        const int val = 10;
+
+        REQUIRE(m.push(val));
+
+        int result;
+        REQUIRE(m.pop(result));
+        CHECK(result == val);
+        CHECK_FALSE(m.pop(result));
+    }
+
+    TEST_CASE("pushing multiple values only keeps the latest") {
+        mpmcplusplus::LatestValue<int> m;
+
+        int result;
+        for (int i = 0; i < 10000; ++i) {
+            REQUIRE(m.push(i));
+            REQUIRE(m.push(i + 1));
+            REQUIRE(m.push(i + 2));
+            REQUIRE(m.pop(result));
+            REQUIRE(result == i + 2);
+            REQUIRE_FALSE(m.pop(result));
+        }
+    }
+
+    TEST_CASE("emplacing values that are not default constructible") {
+        mpmcplusplus::LatestValue<NotDefaultConstructible> m;
+
+        REQUIRE(m.emplace(1));
+        REQUIRE(m.emplace(2));
+
+        NotDefaultConstructible result(0);
+        REQUIRE(m.pop(result));
+        CHECK(result.value == 2);
+        CHECK_FALSE(m.pop(result));
+    }
+
+    TEST_CASE("overwritten and remaining values are destroyed") {
+        std::shared_ptr<int> val = std::make_shared<int>(10);
+        {
+            mpmcplusplus::LatestValue<std::shared_ptr<int>> m;
+            for (int i = 0; i < 10; ++i) {
+                REQUIRE(m.push(val));
+            }
+            REQUIRE(val.use_count() <= 4);
+        }
+        CHECK(val.use_count() == 1);
+    }
+
+    TEST_CASE("popping from empty latest value mailbox with waiting and timeout") {
+        mpmcplusplus::LatestValue<int> m;
+        std::chrono::milliseconds duration(10);
+
+        int result;
+        REQUIRE_FALSE(m.wait_and_pop(result, duration));
+        CHECK_FALSE(m.pop(result));
+    }
+
+    TEST_CASE("single producer single consumer concurrently pushing and popping with waiting") {
+        mpmcplusplus::LatestValue<int> m;
+
+        std::thread pop_thread([&m]() {
+            int previous = -1;
+            int result;
+            do {
+                REQUIRE(m.wait_and_pop(result));
+                REQUIRE(result > previous);
+                previous = result;
+            } while (result != 99999);
+        });
+
+        std::thread push_thread([&m]() {
+            for (int i = 0; i < 100000; ++i) {
+                REQUIRE(m.push(i));
+            }
+        });
+
+        pop_thread.join();
+        push_thread.join();
+
+        int result;
+        CHECK_FALSE(m.pop(result));
+    }
+}
@@ -0,0 +1,137 @@
+/*
+ * test_linked_queue.cpp - Test code for the mpmcplusplus lock-free linked queue
+ * Copyright (C) 2021 James Triantafylos
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "doctest/doctest.h"
+
+#include <atomic>
+#include <memory>
+#include <thread>
+
+#include "mpmcplusplus/epoch_reclaimer.h"
+#include "mpmcplusplus/hazard_pointer_reclaimer.h"
+#include "mpmcplusplus/linked_queue.h"
+
+TEST_SUITE("linked queue") {
+    TEST_CASE_TEMPLATE_DEFINE("popping from empty linked queue", R, linked_empty) {
+        mpmcplusplus::LinkedQueue<int, R> q;
+
+        int result;
+        CHECK_FALSE(q.pop(result));
+    }
+
+    TEST_CASE_TEMPLATE_DEFINE("pushing and then popping multiple values", R, linked_fifo) {
+        mpmcplusplus::LinkedQueue<int, R> q;
+
+        for (int i = 0; i < 10000; ++i) {
+            REQUIRE(q.push(i));
+        }
+
+        int result;
+        for (int i = 0; i < 10000; ++i) {
+            REQUIRE(q.pop(result));
+            REQUIRE(result == i);
+        }
+        CHECK_FALSE(q.pop(result));
+    }
+
+    TEST_CASE_TEMPLATE_DEFINE("emplacing and popping multiple values", R, linked_emplace) {
+        mpmcplusplus::LinkedQueue<std::unique_ptr<int>, R> q;
+
+        for (int i = 0; i < 10000; ++i) {
+            REQUIRE(q.emplace(new int(i)));
+        }
+
+        std::unique_ptr<int> result;
+        for (int i = 0; i < 10000; ++i) {
+            REQUIRE(q.pop(result));
+            REQUIRE(*result == i);
+        }
+        CHECK_FALSE(q.pop(result));
+    }
+
+    TEST_CASE_TEMPLATE_DEFINE("destroying a linked queue destroys the remaining objects", R, linked_destroy) {
+        std::shared_ptr<int> val = std::make_shared<int>(10);
+        {
+            mpmcplusplus::LinkedQueue<std::shared_ptr<int>, R> q;
+            REQUIRE(q.push(val));
+            REQUIRE(q.push(val));
+            REQUIRE(q.push(val));
+            std::shared_ptr<int> result;
+            REQUIRE(q.pop(result));
+            REQUIRE(val.use_count() == 4);
+        }
+        CHECK(val.use_count() == 1);
+    }
+
+    TEST_CASE_TEMPLATE_DEFINE("popping from empty linked queue with waiting and timeout", R, linked_timeout) {
+        mpmcplusplus::LinkedQueue<int, R> q;
+        std::chrono::milliseconds duration(10);
+
+        int result;
+        REQUIRE_FALSE(q.wait_and_pop(result, duration));
+        CHECK_FALSE(q.pop(result));
+    }
+
+    TEST_CASE_TEMPLATE_DEFINE("multi consumer multi producer concurrently pushing and popping with waiting",
+                              R,
+                              linked_threaded) {
+        mpmcplusplus::LinkedQueue<int, R> q;
+        std::atomic<int> popped_count(0);
+        std::atomic<int> popped_sum(0);
+
+        auto pop = [&q, &popped_count, &popped_sum]() {
+            int result;
+            while (popped_count.fetch_add(1) < 30000) {
+                REQUIRE(q.wait_and_pop(result));
+                REQUIRE((result == 1 || result == 2 || result == 3));
+                popped_sum.fetch_add(result);
+            }
+        };
+
+        auto push = [&q](int val) {
+            for (int i = 0; i < 10000; ++i) {
+                REQUIRE(q.push(val));
+            }
+        };
+
+        std::thread pop_thread_1(pop);
+        std::thread pop_thread_2(pop);
+        std::thread pop_thread_3(pop);
+        std::thread push_thread_1(push, 1);
+        std::thread push_thread_2(push, 2);
+        std::thread push_thread_3(push, 3);
+
+        pop_thread_1.join();
+        pop_thread_2.join();
+        pop_thread_3.join();
+        push_thread_1.join();
+        push_thread_2.join();
+        push_thread_3.join();
+
+        CHECK(popped_sum == 60000);
+        int result;
+        CHECK_FALSE(q.pop(result));
+    }
+
+    TEST_CASE_TEMPLATE_INVOKE(linked_empty, mpmcplusplus::EpochReclaimer, mpmcplusplus::HazardPointerReclaimer);
+    TEST_CASE_TEMPLATE_INVOKE(linked_fifo, mpmcplusplus::EpochReclaimer, mpmcplusplus::HazardPointerReclaimer);
+    TEST_CASE_TEMPLATE_INVOKE(linked_emplace, mpmcplusplus::EpochReclaimer, mpmcplusplus::HazardPointerReclaimer);
+    TEST_CASE_TEMPLATE_INVOKE(linked_destroy, mpmcplusplus::EpochReclaimer, mpmcplusplus::HazardPointerReclaimer);
+    TEST_CASE_TEMPLATE_INVOKE(linked_timeout, mpmcplusplus::EpochReclaimer, mpmcplusplus::HazardPointerReclaimer);
+    TEST_CASE_TEMPLATE_INVOKE(linked_threaded, mpmcplusplus::EpochReclaimer, mpmcplusplus::HazardPointerReclaimer);
+}
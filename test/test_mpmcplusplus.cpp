@@ -20,7 +20,14 @@
 #include "doctest/doctest.h"
 
 #include <atomic>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <queue>
+#include <stdexcept>
 #include <thread>
+#include <type_traits>
+#include <vector>
 
 #include "mpmcplusplus/mpmcplusplus.h"
 
@@ -555,4 +562,560 @@ TEST_SUITE("queue") {
         std::unique_ptr<int> result;
         CHECK_FALSE(q.pop(result));
     }
+
+    TEST_CASE("creating a bounded queue") {
+        mpmcplusplus::Queue<int> q(4);
+
+        CHECK(q.capacity() == 4);
+    }
+
+    TEST_CASE("creating a bounded queue with a capacity of zero") {
+        CHECK_THROWS_AS((mpmcplusplus::Queue<int>(0)), std::invalid_argument);
+    }
+
+    TEST_CASE("pushing to a full bounded queue") {
+        mpmcplusplus::Queue<int> q(4);
+
+        for (int i = 0; i < 4; ++i) {
+            REQUIRE(q.push(i));
+        }
+        CHECK_FALSE(q.push(4));
+        CHECK_FALSE(q.emplace(4));
+
+        int result;
+        REQUIRE(q.pop(result));
+        CHECK(result == 0);
+        CHECK(q.push(4));
+    }
+
+    TEST_CASE("emplacing in a full bounded queue with waiting and timeout") {
+        mpmcplusplus::Queue<std::unique_ptr<int>> q(1);
+        std::chrono::milliseconds duration(10);
+
+        REQUIRE(q.wait_and_emplace_for(duration, new int(10)));
+        CHECK_FALSE(q.wait_and_emplace_for(duration, nullptr));
+
+        std::unique_ptr<int> result;
+        REQUIRE(q.pop(result));
+        CHECK(*result == 10);
+        REQUIRE(q.wait_and_emplace_for(duration, new int(20)));
+        REQUIRE(q.pop(result));
+        CHECK(*result == 20);
+    }
+
+    TEST_CASE("pushing to a full bounded queue with waiting and timeout") {
+        mpmcplusplus::Queue<std::unique_ptr<int>> q(1);
+        std::chrono::milliseconds duration(10);
+
+        REQUIRE(q.wait_and_push(std::unique_ptr<int>(new int(10)), duration));
+
+        std::unique_ptr<int> val(new int(20));
+        REQUIRE_FALSE(q.wait_and_push(std::move(val), duration));
+        REQUIRE(val != nullptr);
+
+        std::unique_ptr<int> result;
+        REQUIRE(q.pop(result));
+        CHECK(*result == 10);
+        CHECK(q.wait_and_push(std::move(val), duration));
+    }
+
+    TEST_CASE("single producer single consumer concurrently pushing and popping with backpressure") {
+        mpmcplusplus::Queue<int> q(8);
+
+        std::thread pop_thread([&q]() {
+            int result;
+            for (int i = 0; i < 10000; ++i) {
+                REQUIRE(q.wait_and_pop(result));
+                REQUIRE(result == i);
+            }
+        });
+
+        std::thread push_thread([&q]() {
+            for (int i = 0; i < 10000; ++i) {
+                REQUIRE(q.wait_and_push(i));
+            }
+        });
+
+        pop_thread.join();
+        push_thread.join();
+
+        int result;
+        CHECK_FALSE(q.pop(result));
+    }
+
+    TEST_CASE("multi consumer multi producer concurrently emplacing and popping with backpressure") {
+        mpmcplusplus::Queue<std::unique_ptr<int>> q(8);
+        std::atomic<int> popped_count(0);
+        std::atomic<int> popped_sum(0);
+
+        auto pop = [&q, &popped_count, &popped_sum]() {
+            std::unique_ptr<int> result;
+            while (popped_count.fetch_add(1) < 30000) {
+                REQUIRE(q.wait_and_pop(result));
+                popped_sum.fetch_add(*result);
+            }
+        };
+
+        auto push = [&q](int val) {
+            for (int i = 0; i < 10000; ++i) {
+                REQUIRE(q.wait_and_emplace(new int(val)));
+            }
+        };
+
+        std::thread pop_thread_1(pop);
+        std::thread pop_thread_2(pop);
+        std::thread pop_thread_3(pop);
+        std::thread push_thread_1(push, 1);
+        std::thread push_thread_2(push, 2);
+        std::thread push_thread_3(push, 3);
+
+        pop_thread_1.join();
+        pop_thread_2.join();
+        pop_thread_3.join();
+        push_thread_1.join();
+        push_thread_2.join();
+        push_thread_3.join();
+
+        CHECK(popped_sum == 60000);
+        std::unique_ptr<int> result;
+        CHECK_FALSE(q.pop(result));
+    }
+
+    TEST_CASE("pushing and popping in bulk") {
+        mpmcplusplus::Queue<int> q;
+        std::vector<int> values;
+        for (int i = 0; i < 100; ++i) {
+            values.push_back(i);
+        }
+
+        REQUIRE(q.push_bulk(values.begin(), values.end()) == 100);
+
+        std::vector<int> results;
+        REQUIRE(q.pop_bulk(std::back_inserter(results), 60) == 60);
+        REQUIRE(q.pop_bulk(std::back_inserter(results), 60) == 40);
+        CHECK(results == values);
+        CHECK(q.pop_bulk(std::back_inserter(results), 60) == 0);
+    }
+
+    TEST_CASE("pushing in bulk to a bounded queue") {
+        mpmcplusplus::Queue<int> q(4);
+        const int values[] = {0, 1, 2, 3, 4, 5};
+
+        CHECK(q.push_bulk(values, values + 6) == 4);
+        CHECK(q.push_bulk(values + 4, values + 6) == 0);
+
+        int results[6];
+        REQUIRE(q.pop_bulk(results, 6) == 4);
+        for (int i = 0; i < 4; ++i) {
+            CHECK(results[i] == i);
+        }
+    }
+
+    TEST_CASE("moving and emplacing in bulk") {
+        mpmcplusplus::Queue<std::unique_ptr<int>> q;
+        std::vector<std::unique_ptr<int>> owned;
+        owned.emplace_back(new int(0));
+        owned.emplace_back(new int(1));
+        int* raw[] = {new int(2), new int(3)};
+
+        REQUIRE(q.push_bulk(std::make_move_iterator(owned.begin()), std::make_move_iterator(owned.end())) == 2);
+        REQUIRE(q.emplace_bulk(raw, raw + 2) == 2);
+
+        std::vector<std::unique_ptr<int>> results;
+        REQUIRE(q.pop_bulk(std::back_inserter(results), 10) == 4);
+        for (int i = 0; i < 4; ++i) {
+            CHECK(*results[static_cast<std::size_t>(i)] == i);
+        }
+    }
+
+    TEST_CASE("pushing in bulk wakes waiting consumers for objects pushed before an exception") {
+        struct NonNegative {
+            int value;
+
+            NonNegative(int v) : value(v) {
+                if (v < 0) {
+                    throw std::invalid_argument("negative");
+                }
+            }
+        };
+
+        mpmcplusplus::Queue<NonNegative> q;
+        std::atomic<int> popped_sum(0);
+        auto pop = [&q, &popped_sum]() {
+            NonNegative result(0);
+            REQUIRE(q.wait_and_pop(result));
+            popped_sum += result.value;
+        };
+
+        std::thread pop_thread_1(pop);
+        std::thread pop_thread_2(pop);
+
+        int values[] = {1, 2, -1, 4};
+        CHECK_THROWS_AS(q.emplace_bulk(values, values + 4), std::invalid_argument);
+
+        pop_thread_1.join();
+        pop_thread_2.join();
+        CHECK(popped_sum == 3);
+        NonNegative result(0);
+        CHECK_FALSE(q.pop(result));
+    }
+
+    TEST_CASE("popping in bulk from empty queue with waiting and timeout") {
+        mpmcplusplus::Queue<int> q;
+        std::chrono::milliseconds duration(10);
+
+        std::vector<int> results;
+        REQUIRE(q.wait_and_pop_bulk(std::back_inserter(results), 10, duration) == 0);
+        CHECK(results.empty());
+    }
+
+    TEST_CASE("multi consumer multi producer concurrently pushing and popping in bulk with waiting") {
+        mpmcplusplus::Queue<int> q(256);
+        std::atomic<int> popped_count(0);
+        std::atomic<int> popped_sum(0);
+
+        auto pop = [&q, &popped_count, &popped_sum]() {
+            std::vector<int> results;
+            while (popped_count.load() < 30000) {
+                results.clear();
+                if (q.wait_and_pop_bulk(std::back_inserter(results), 64, std::chrono::milliseconds(10)) == 0) {
+                    continue;
+                }
+                for (int result : results) {
+                    popped_sum.fetch_add(result);
+                }
+                popped_count.fetch_add(static_cast<int>(results.size()));
+            }
+        };
+
+        auto push = [&q](int val) {
+            const std::vector<int> batch(100, val);
+            for (int i = 0; i < 100; ++i) {
+                std::vector<int>::const_iterator first = batch.begin();
+                while (first != batch.end()) {
+                    first += static_cast<std::ptrdiff_t>(q.push_bulk(first, batch.end()));
+                }
+            }
+        };
+
+        std::thread pop_thread_1(pop);
+        std::thread pop_thread_2(pop);
+        std::thread pop_thread_3(pop);
+        std::thread push_thread_1(push, 1);
+        std::thread push_thread_2(push, 2);
+        std::thread push_thread_3(push, 3);
+
+        pop_thread_1.join();
+        pop_thread_2.join();
+        pop_thread_3.join();
+        push_thread_1.join();
+        push_thread_2.join();
+        push_thread_3.join();
+
+        CHECK(popped_count == 30000);
+        CHECK(popped_sum == 60000);
+        int result;
+        CHECK_FALSE(q.pop(result));
+    }
+
+    TEST_CASE("draining a queue") {
+        mpmcplusplus::Queue<int> q;
+        for (int i = 0; i < 100; ++i) {
+            REQUIRE(q.push(i));
+        }
+
+        mpmcplusplus::Queue<int>::storage_type drained;
+        REQUIRE(q.drain(drained));
+        REQUIRE(drained.size() == 100);
+        for (int i = 0; i < 100; ++i) {
+            REQUIRE(drained.front() == i);
+            drained.pop();
+        }
+        int result;
+        CHECK_FALSE(q.pop(result));
+    }
+
+    TEST_CASE("draining an empty queue") {
+        mpmcplusplus::Queue<int> q;
+        std::chrono::milliseconds duration(10);
+
+        mpmcplusplus::Queue<int>::storage_type drained;
+        CHECK_FALSE(q.drain(drained));
+        CHECK_FALSE(q.wait_and_drain(drained, duration));
+        CHECK(drained.empty());
+    }
+
+    TEST_CASE("draining into a container that is not empty") {
+        mpmcplusplus::Queue<int> q(2);
+        std::chrono::milliseconds duration(10);
+        REQUIRE(q.push(1));
+        REQUIRE(q.push(2));
+
+        std::queue<int> drained;
+        drained.push(100);
+        CHECK_FALSE(q.drain(drained));
+        CHECK_FALSE(q.wait_and_drain(drained));
+        CHECK_FALSE(q.wait_and_drain(drained, duration));
+        CHECK(drained.size() == 1);
+
+        int result;
+        REQUIRE(q.pop(result));
+        CHECK(result == 1);
+        REQUIRE(q.pop(result));
+        CHECK(result == 2);
+        CHECK_FALSE(q.pop(result));
+    }
+
+    TEST_CASE("draining a ring buffer queue recycles the storage") {
+        mpmcplusplus::Queue<int, mpmcplusplus::RingBuffer<int>> q;
+        mpmcplusplus::RingBuffer<int> drained;
+
+        for (int round = 0; round < 3; ++round) {
+            for (int i = 0; i < 50; ++i) {
+                REQUIRE(q.push(round * 50 + i));
+            }
+            REQUIRE(q.drain(drained));
+            REQUIRE(drained.size() == 50);
+            for (int i = 0; i < 50; ++i) {
+                REQUIRE(drained.front() == round * 50 + i);
+                drained.pop();
+            }
+        }
+        CHECK(drained.empty());
+    }
+
+    TEST_CASE("draining a full bounded queue makes room for waiting producers") {
+        mpmcplusplus::Queue<int> q(4);
+        for (int i = 0; i < 4; ++i) {
+            REQUIRE(q.push(i));
+        }
+
+        std::thread push_thread([&q]() {
+            for (int i = 4; i < 8; ++i) {
+                REQUIRE(q.wait_and_push(i));
+            }
+        });
+
+        std::queue<int> drained;
+        int expected = 0;
+        while (expected < 8) {
+            REQUIRE(q.wait_and_drain(drained));
+            while (!drained.empty()) {
+                REQUIRE(drained.front() == expected++);
+                drained.pop();
+            }
+        }
+        push_thread.join();
+    }
+
+    TEST_CASE("multi producer single consumer concurrently pushing and draining with waiting") {
+        mpmcplusplus::Queue<int> q;
+
+        auto push = [&q](int val) {
+            for (int i = 0; i < 10000; ++i) {
+                REQUIRE(q.push(val));
+            }
+        };
+
+        std::thread push_thread_1(push, 1);
+        std::thread push_thread_2(push, 2);
+        std::thread push_thread_3(push, 3);
+
+        std::queue<int> drained;
+        int popped_count = 0;
+        int popped_sum = 0;
+        while (popped_count < 30000) {
+            REQUIRE(q.wait_and_drain(drained));
+            while (!drained.empty()) {
+                popped_sum += drained.front();
+                ++popped_count;
+                drained.pop();
+            }
+        }
+
+        push_thread_1.join();
+        push_thread_2.join();
+        push_thread_3.join();
+
+        CHECK(popped_count == 30000);
+        CHECK(popped_sum == 60000);
+        int result;
+        CHECK_FALSE(q.pop(result));
+    }
+}
+
+TEST_SUITE("policy-based queue") {
+    TEST_CASE_TEMPLATE_DEFINE("pushing and then popping multiple values", Q, policy_fifo) {
+        Q q;
+
+        for (int i = 0; i < 10000; ++i) {
+            REQUIRE(q.push(i));
+        }
+
+        int result;
+        for (int i = 0; i < 10000; ++i) {
+            REQUIRE(q.pop(result));
+            REQUIRE(result == i);
+        }
+        CHECK_FALSE(q.pop(result));
+    }
+
+    TEST_CASE_TEMPLATE_DEFINE("popping from empty queue with waiting and timeout", Q, policy_timeout) {
+        Q q;
+        std::chrono::milliseconds duration(10);
+
+        int result;
+        REQUIRE_FALSE(q.wait_and_pop(result, duration));
+        CHECK_FALSE(q.pop(result));
+    }
+
+    TEST_CASE_TEMPLATE_DEFINE("multi consumer multi producer concurrently pushing and popping with backpressure",
+                              Q,
+                              policy_threaded) {
+        Q q(8);
+        std::atomic<int> popped_count(0);
+        std::atomic<int> popped_sum(0);
+
+        auto pop = [&q, &popped_count, &popped_sum]() {
+            int result;
+            while (popped_count.fetch_add(1) < 30000) {
+                REQUIRE(q.wait_and_pop(result));
+                popped_sum.fetch_add(result);
+            }
+        };
+
+        auto push = [&q](int val) {
+            for (int i = 0; i < 10000; ++i) {
+                REQUIRE(q.wait_and_push(val));
+            }
+        };
+
+        std::thread pop_thread_1(pop);
+        std::thread pop_thread_2(pop);
+        std::thread pop_thread_3(pop);
+        std::thread push_thread_1(push, 1);
+        std::thread push_thread_2(push, 2);
+        std::thread push_thread_3(push, 3);
+
+        pop_thread_1.join();
+        pop_thread_2.join();
+        pop_thread_3.join();
+        push_thread_1.join();
+        push_thread_2.join();
+        push_thread_3.join();
+
+        CHECK(popped_sum == 60000);
+        int result;
+        CHECK_FALSE(q.pop(result));
+    }
+
+    typedef mpmcplusplus::Queue<int, mpmcplusplus::RingBuffer<int>> RingBufferQueue;
+    typedef mpmcplusplus::Queue<int, std::queue<int>, mpmcplusplus::SpinLock> SpinLockQueue;
+    TEST_CASE_TEMPLATE_INVOKE(policy_fifo, RingBufferQueue, SpinLockQueue);
+    TEST_CASE_TEMPLATE_INVOKE(policy_timeout, RingBufferQueue, SpinLockQueue);
+    TEST_CASE_TEMPLATE_INVOKE(policy_threaded, RingBufferQueue, SpinLockQueue);
+
+#if defined(__linux__)
+    typedef mpmcplusplus::Queue<int, mpmcplusplus::RingBuffer<int>, mpmcplusplus::SpinLock, mpmcplusplus::FutexWait>
+        FutexQueue;
+    TEST_CASE_TEMPLATE_INVOKE(policy_fifo, FutexQueue);
+    TEST_CASE_TEMPLATE_INVOKE(policy_timeout, FutexQueue);
+    typedef mpmcplusplus::FixedQueue<int, 8> InlineQueue;
+    TEST_CASE_TEMPLATE_INVOKE(policy_timeout, InlineQueue);
+    TEST_CASE_TEMPLATE_INVOKE(policy_threaded, InlineQueue);
+
+    TEST_CASE_TEMPLATE_INVOKE(policy_threaded, FutexQueue);
+
+    TEST_CASE("popping from a futex queue with a negative or huge timeout") {
+        FutexQueue q;
+
+        int result;
+        CHECK_FALSE(q.wait_and_pop(result, std::chrono::milliseconds(-10)));
+
+        std::thread push_thread([&q]() {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            q.push(1);
+        });
+        REQUIRE(q.wait_and_pop(result, std::chrono::hours::max()));
+        CHECK(result == 1);
+        push_thread.join();
+    }
+#endif
+}
+
+TEST_SUITE("fixed queue") {
+    TEST_CASE("creating a fixed queue") {
+        mpmcplusplus::FixedQueue<int, 16> q;
+
+        CHECK(q.capacity() == 16);
+    }
+
+    TEST_CASE("creating a fixed queue with a larger capacity than its storage") {
+        mpmcplusplus::FixedQueue<int, 16> q(100);
+
+        CHECK(q.capacity() == 16);
+    }
+
+    TEST_CASE("pushing to a full fixed queue") {
+        mpmcplusplus::FixedQueue<int, 4> q;
+
+        for (int i = 0; i < 4; ++i) {
+            REQUIRE(q.push(i));
+        }
+        REQUIRE_FALSE(q.push(4));
+
+        int result;
+        REQUIRE(q.pop(result));
+        CHECK(result == 0);
+        CHECK(q.push(4));
+        CHECK_FALSE(q.push(5));
+    }
+
+    TEST_CASE("pushing and popping across the end of the storage") {
+        mpmcplusplus::FixedQueue<int, 4> q;
+
+        int result;
+        for (int i = 0; i < 10000; ++i) {
+            REQUIRE(q.push(i));
+            REQUIRE(q.push(i + 1));
+            REQUIRE(q.pop(result));
+            REQUIRE(result == i);
+            REQUIRE(q.pop(result));
+            REQUIRE(result == i + 1);
+        }
+        CHECK_FALSE(q.pop(result));
+    }
+
+    TEST_CASE("destroying a fixed queue that still holds values") {
+        std::shared_ptr<int> value(new int(10));
+        {
+            mpmcplusplus::FixedQueue<std::shared_ptr<int>, 8> q;
+            for (int i = 0; i < 8; ++i) {
+                REQUIRE(q.push(value));
+            }
+            std::shared_ptr<int> result;
+            REQUIRE(q.pop(result));
+            REQUIRE(q.emplace(value));
+        }
+        CHECK(value.use_count() == 1);
+    }
+
+    TEST_CASE("constructing a fixed queue in pre-allocated memory") {
+        typedef mpmcplusplus::FixedQueue<int, 64> Q;
+        std::aligned_storage<sizeof(Q), alignof(Q)>::type memory;
+
+        Q* q = new (&memory) Q();
+        for (int i = 0; i < 64; ++i) {
+            REQUIRE(q->push(i));
+        }
+        CHECK_FALSE(q->push(64));
+
+        int result;
+        for (int i = 0; i < 64; ++i) {
+            REQUIRE(q->pop(result));
+            REQUIRE(result == i);
+        }
+        CHECK_FALSE(q->pop(result));
+        q->~Q();
+    }
 }
\ No newline at end of file
@@ -0,0 +1,130 @@
+/*
+ * test_mpsc_queue.cpp - Test code for the mpmcplusplus multi producer single consumer queue
+ * Copyright (C) 2021 James Triantafylos
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "doctest/doctest.h"
+
+#include <memory>
+#include <thread>
+
+#include "mpmcplusplus/mpsc_queue.h"
+
+TEST_SUITE("mpsc queue") {
+    TEST_CASE("creating an mpsc queue") { mpmcplusplus::MpscQueue<int> q; }
+
+    TEST_CASE("popping from empty mpsc queue") {
+        mpmcplusplus::MpscQueue<int> q;
+
+        int result;
+        CHECK_FALSE(q.pop(result));
+    }
+
+    TEST_CASE("pushing and popping one lvalue") {
+        mpmcplusplus::MpscQueue<int> q;
+        const int val = 10;
+
+        REQUIRE(q.push(val));
+
+        int result;
+        REQUIRE(q.pop(result));
+        CHECK(result == val);
+        CHECK_FALSE(q.pop(result));
+    }
+
+    TEST_CASE("pushing and then popping multiple values") {
+        mpmcplusplus::MpscQueue<int> q;
+
+        for (int i = 0; i < 10000; ++i) {
+            REQUIRE(q.push(i));
+        }
+
+        int result;
+        for (int i = 0; i < 10000; ++i) {
+            REQUIRE(q.pop(result));
+            REQUIRE(result == i);
+        }
+        CHECK_FALSE(q.pop(result));
+    }
+
+    TEST_CASE("emplacing and popping multiple values") {
+        mpmcplusplus::MpscQueue<std::unique_ptr<int>> q;
+
+        for (int i = 0; i < 10000; ++i) {
+            REQUIRE(q.emplace(new int(i)));
+        }
+
+        std::unique_ptr<int> result;
+        for (int i = 0; i < 10000; ++i) {
+            REQUIRE(q.pop(result));
+            REQUIRE(*result == i);
+        }
+        CHECK_FALSE(q.pop(result));
+    }
+
+    TEST_CASE("destroying an mpsc queue destroys the remaining objects") {
+        std::shared_ptr<int> val = std::make_shared<int>(10);
+        {
+            mpmcplusplus::MpscQueue<std::shared_ptr<int>> q;
+            REQUIRE(q.push(val));
+            REQUIRE(q.push(val));
+            REQUIRE(val.use_count() == 3);
+        }
+        CHECK(val.use_count() == 1);
+    }
+
+    TEST_CASE("popping from empty mpsc queue with waiting and timeout") {
+        mpmcplusplus::MpscQueue<int> q;
+        std::chrono::milliseconds duration(10);
+
+        int result;
+        REQUIRE_FALSE(q.wait_and_pop(result, duration));
+        CHECK_FALSE(q.pop(result));
+    }
+
+    TEST_CASE("multi producer single consumer concurrently pushing and popping with waiting") {
+        mpmcplusplus::MpscQueue<int> q;
+
+        auto push = [&q](int producer) {
+            for (int i = 0; i < 10000; ++i) {
+                REQUIRE(q.push(producer * 10000 + i));
+            }
+        };
+
+        std::thread pop_thread([&q]() {
+            int next_expected[3] = {0, 10000, 20000};
+            int result;
+            for (int i = 0; i < 30000; ++i) {
+                REQUIRE(q.wait_and_pop(result));
+                int producer = result / 10000;
+                REQUIRE(result == next_expected[producer]);
+                next_expected[producer]++;
+            }
+        });
+
+        std::thread push_thread_1(push, 0);
+        std::thread push_thread_2(push, 1);
+        std::thread push_thread_3(push, 2);
+
+        pop_thread.join();
+        push_thread_1.join();
+        push_thread_2.join();
+        push_thread_3.join();
+
+        int result;
+        CHECK_FALSE(q.pop(result));
+    }
+}
@@ -0,0 +1,149 @@
+/*
+ * test_priority_lane_queue.cpp - Test code for the mpmcplusplus priority lane queue
+ * Copyright (C) 2021 James Triantafylos
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "doctest/doctest.h"
+
+#include <atomic>
+#include <memory>
+#include <thread>
+
+#include "mpmcplusplus/priority_lane_queue.h"
+
+TEST_SUITE("priority lane queue") {
+    TEST_CASE("creating a priority lane queue") {
+        mpmcplusplus::PriorityLaneQueue<int, 4> q;
+
+        CHECK(q.lane_count() == 4);
+    }
+
+    TEST_CASE("popping from empty priority lane queue") {
+        mpmcplusplus::PriorityLaneQueue<int, 4> q;
+
+        int result;
+        CHECK_FALSE(q.pop(result));
+    }
+
+    TEST_CASE("pushing to a lane that does not exist") {
+        mpmcplusplus::PriorityLaneQueue<int, 4> q;
+
+        CHECK_FALSE(q.push(4, 1));
+        int result;
+        CHECK_FALSE(q.pop(result));
+    }
+
+    TEST_CASE("higher priority lanes are popped first") {
+        mpmcplusplus::PriorityLaneQueue<int, 8> q;
+
+        REQUIRE(q.push(7, 70));
+        REQUIRE(q.push(3, 30));
+        REQUIRE(q.push(0, 0));
+        REQUIRE(q.push(3, 31));
+        REQUIRE(q.push(5, 50));
+
+        int result;
+        REQUIRE(q.pop(result));
+        CHECK(result == 0);
+        REQUIRE(q.pop(result));
+        CHECK(result == 30);
+        REQUIRE(q.pop(result));
+        CHECK(result == 31);
+        REQUIRE(q.pop(result));
+        CHECK(result == 50);
+        REQUIRE(q.pop(result));
+        CHECK(result == 70);
+        CHECK_FALSE(q.pop(result));
+    }
+
+    TEST_CASE("using all 64 lanes") {
+        mpmcplusplus::PriorityLaneQueue<int, 64> q;
+
+        for (int lane = 63; lane >= 0; --lane) {
+            REQUIRE(q.push(lane, lane));
+        }
+
+        int result;
+        for (int lane = 0; lane < 64; ++lane) {
+            REQUIRE(q.pop(result));
+            REQUIRE(result == lane);
+        }
+        CHECK_FALSE(q.pop(result));
+    }
+
+    TEST_CASE("emplacing and popping multiple values in one lane") {
+        mpmcplusplus::PriorityLaneQueue<std::unique_ptr<int>, 2> q;
+
+        for (int i = 0; i < 10000; ++i) {
+            REQUIRE(q.emplace(1, new int(i)));
+        }
+
+        std::unique_ptr<int> result;
+        for (int i = 0; i < 10000; ++i) {
+            REQUIRE(q.pop(result));
+            REQUIRE(*result == i);
+        }
+        CHECK_FALSE(q.pop(result));
+    }
+
+    TEST_CASE("popping from empty priority lane queue with waiting and timeout") {
+        mpmcplusplus::PriorityLaneQueue<int, 4> q;
+        std::chrono::milliseconds duration(10);
+
+        int result;
+        REQUIRE_FALSE(q.wait_and_pop(result, duration));
+        CHECK_FALSE(q.pop(result));
+    }
+
+    TEST_CASE("multi consumer multi producer concurrently pushing to different lanes with waiting") {
+        mpmcplusplus::PriorityLaneQueue<int, 4> q;
+        std::atomic<int> popped_count(0);
+        std::atomic<int> popped_sum(0);
+
+        auto pop = [&q, &popped_count, &popped_sum]() {
+            int result;
+            while (popped_count.fetch_add(1) < 30000) {
+                REQUIRE(q.wait_and_pop(result));
+                REQUIRE((result == 1 || result == 2 || result == 3));
+                popped_sum.fetch_add(result);
+            }
+        };
+
+        auto push = [&q](int val) {
+            for (int i = 0; i < 10000; ++i) {
+                REQUIRE(q.push(static_cast<std::size_t>(val), val));
+            }
+        };
+
+        std::thread pop_thread_1(pop);
+        std::thread pop_thread_2(pop);
+        std::thread pop_thread_3(pop);
+        std::thread push_thread_1(push, 1);
+        std::thread push_thread_2(push, 2);
+        std::thread push_thread_3(push, 3);
+
+        pop_thread_1.join();
+        pop_thread_2.join();
+        pop_thread_3.join();
+        push_thread_1.join();
+        push_thread_2.join();
+        push_thread_3.join();
+
+        CHECK(popped_sum == 60000);
+        int result;
+        CHECK_FALSE(q.pop(result));
+    }
+}
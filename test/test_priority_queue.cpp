@@ -0,0 +1,173 @@
+/*
+ * test_priority_queue.cpp - Test code for the mpmcplusplus priority queue
+ * Copyright (C) 2021 James Triantafylos
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "doctest/doctest.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "mpmcplusplus/priority_queue.h"
+
+TEST_SUITE("priority queue") {
+    TEST_CASE("creating a priority queue") {
+        mpmcplusplus::PriorityQueue<int> q;
+
+        CHECK(q.heap_count() >= 1);
+    }
+
+    TEST_CASE("popping from empty priority queue") {
+        mpmcplusplus::PriorityQueue<int> q(4);
+
+        int result;
+        CHECK_FALSE(q.pop(result));
+    }
+
+    TEST_CASE("pushing and popping one lvalue") {
+        mpmcplusplus::PriorityQueue<int> q(4);
+        const int val = 10;
+
+        REQUIRE(q.push(val));
+
+        int result;
+        REQUIRE(q.pop(result));
+        CHECK(result == val);
+        CHECK_FALSE(q.pop(result));
+    }
+
+    TEST_CASE("popping from a single heap is in strict priority order") {
+        mpmcplusplus::PriorityQueue<int> q(1);
+
+        for (int i = 0; i < 1000; ++i) {
+            REQUIRE(q.push((i * 7919) % 1000));
+        }
+
+        int result;
+        for (int i = 999; i >= 0; --i) {
+            REQUIRE(q.pop(result));
+            REQUIRE(result == i);
+        }
+        CHECK_FALSE(q.pop(result));
+    }
+
+    TEST_CASE("popping with a custom comparator") {
+        mpmcplusplus::PriorityQueue<int, std::greater<int>> q(1);
+
+        REQUIRE(q.push(3));
+        REQUIRE(q.push(1));
+        REQUIRE(q.push(2));
+
+        int result;
+        REQUIRE(q.pop(result));
+        CHECK(result == 1);
+        REQUIRE(q.pop(result));
+        CHECK(result == 2);
+        REQUIRE(q.pop(result));
+        CHECK(result == 3);
+    }
+
+    TEST_CASE("popping with a comparator that is not default constructible") {
+        int target = 10;
+        auto closer = [&target](int first, int second) {
+            return std::abs(first - target) > std::abs(second - target);
+        };
+        mpmcplusplus::PriorityQueue<int, decltype(closer)> q(1, closer);
+
+        REQUIRE(q.push(1));
+        REQUIRE(q.push(12));
+        REQUIRE(q.push(20));
+
+        int result;
+        REQUIRE(q.pop(result));
+        CHECK(result == 12);
+        REQUIRE(q.pop(result));
+        CHECK(result == 1);
+        REQUIRE(q.pop(result));
+        CHECK(result == 20);
+    }
+
+    TEST_CASE("popping from many heaps returns every value exactly once") {
+        mpmcplusplus::PriorityQueue<std::unique_ptr<int>, std::function<bool(const std::unique_ptr<int>&,
+                                                                             const std::unique_ptr<int>&)>>
+            q(8, [](const std::unique_ptr<int>& a, const std::unique_ptr<int>& b) { return *a < *b; });
+
+        for (int i = 0; i < 1000; ++i) {
+            REQUIRE(q.emplace(new int(i)));
+        }
+
+        std::vector<bool> seen(1000, false);
+        std::unique_ptr<int> result;
+        for (int i = 0; i < 1000; ++i) {
+            REQUIRE(q.pop(result));
+            REQUIRE_FALSE(seen[*result]);
+            seen[*result] = true;
+        }
+        CHECK_FALSE(q.pop(result));
+    }
+
+    TEST_CASE("popping from empty priority queue with waiting and timeout") {
+        mpmcplusplus::PriorityQueue<int> q(4);
+        std::chrono::milliseconds duration(10);
+
+        int result;
+        REQUIRE_FALSE(q.wait_and_pop(result, duration));
+        CHECK_FALSE(q.pop(result));
+    }
+
+    TEST_CASE("multi consumer multi producer concurrently pushing and popping with waiting") {
+        mpmcplusplus::PriorityQueue<int> q(8);
+        std::atomic<int> popped_count(0);
+        std::atomic<int> popped_sum(0);
+
+        auto pop = [&q, &popped_count, &popped_sum]() {
+            int result;
+            while (popped_count.fetch_add(1) < 30000) {
+                REQUIRE(q.wait_and_pop(result));
+                REQUIRE((result == 1 || result == 2 || result == 3));
+                popped_sum.fetch_add(result);
+            }
+        };
+
+        auto push = [&q](int val) {
+            for (int i = 0; i < 10000; ++i) {
+                REQUIRE(q.push(val));
+            }
+        };
+
+        std::thread pop_thread_1(pop);
+        std::thread pop_thread_2(pop);
+        std::thread pop_thread_3(pop);
+        std::thread push_thread_1(push, 1);
+        std::thread push_thread_2(push, 2);
+        std::thread push_thread_3(push, 3);
+
+        pop_thread_1.join();
+        pop_thread_2.join();
+        pop_thread_3.join();
+        push_thread_1.join();
+        push_thread_2.join();
+        push_thread_3.join();
+
+        CHECK(popped_sum == 60000);
+        int result;
+        CHECK_FALSE(q.pop(result));
+    }
+}
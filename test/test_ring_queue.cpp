@@ -0,0 +1,222 @@
+/*
+ * test_ring_queue.cpp - Test code for the mpmcplusplus ring queue
+ * Copyright (C) 2021 James Triantafylos
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "doctest/doctest.h"
+
+#include <atomic>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+
+#include "mpmcplusplus/ring_queue.h"
+
+namespace {
+    struct Checked {
+        int value;
+
+        Checked() : value(0) {}
+        explicit Checked(int value) : value(value) {
+            if (value < 0) {
+                throw std::invalid_argument("negative value");
+            }
+        }
+    };
+}
+
+TEST_SUITE("ring queue") {
+    TEST_CASE("creating a ring queue") {
+        mpmcplusplus::RingQueue<int> q(100);
+
+        CHECK(q.capacity() == 128);
+    }
+
+    TEST_CASE("popping from empty ring queue") {
+        mpmcplusplus::RingQueue<int> q(16);
+
+        int result;
+        CHECK_FALSE(q.pop(result));
+    }
+
+    TEST_CASE("pushing and popping one lvalue") {
+        mpmcplusplus::RingQueue<int> q(16);
+        const int val = 10;
+
+        REQUIRE(q.push(val));
+
+        int result;
+        REQUIRE(q.pop(result));
+        CHECK(result == val);
+        CHECK_FALSE(q.pop(result));
+    }
+
+    TEST_CASE("pushing to a full ring queue") {
+        mpmcplusplus::RingQueue<int> q(4);
+
+        for (int i = 0; i < 4; ++i) {
+            REQUIRE(q.push(i));
+        }
+        CHECK_FALSE(q.push(4));
+
+        int result;
+        REQUIRE(q.pop(result));
+        CHECK(result == 0);
+        CHECK(q.push(4));
+    }
+
+    TEST_CASE("interleaved pushing and popping wraps around the ring") {
+        mpmcplusplus::RingQueue<int> q(4);
+
+        int result;
+        for (int i = 0; i < 10000; ++i) {
+            REQUIRE(q.push(i));
+            REQUIRE(q.push(i + 1));
+            REQUIRE(q.push(i + 2));
+
+            REQUIRE(q.pop(result));
+            REQUIRE(result == i);
+            REQUIRE(q.pop(result));
+            REQUIRE(result == i + 1);
+            REQUIRE(q.pop(result));
+            REQUIRE(result == i + 2);
+        }
+        CHECK_FALSE(q.pop(result));
+    }
+
+    TEST_CASE("emplacing and popping multiple values") {
+        mpmcplusplus::RingQueue<std::unique_ptr<int>> q(1024);
+
+        for (int i = 0; i < 1000; ++i) {
+            REQUIRE(q.emplace(new int(i)));
+        }
+
+        std::unique_ptr<int> result;
+        for (int i = 0; i < 1000; ++i) {
+            REQUIRE(q.pop(result));
+            REQUIRE(*result == i);
+        }
+        CHECK_FALSE(q.pop(result));
+    }
+
+    TEST_CASE("a throwing constructor does not leave a gap consumers wait on") {
+        mpmcplusplus::RingQueue<Checked> q(4);
+
+        REQUIRE(q.emplace(1));
+        CHECK_THROWS_AS(q.emplace(-1), std::invalid_argument);
+        REQUIRE(q.emplace(2));
+
+        Checked result;
+        REQUIRE(q.pop(result));
+        CHECK(result.value == 1);
+        REQUIRE(q.pop(result));
+        CHECK(result.value == 2);
+        CHECK_FALSE(q.pop(result));
+
+        for (int i = 0; i < 4; ++i) {
+            REQUIRE(q.emplace(i));
+            REQUIRE(q.pop(result));
+            CHECK(result.value == i);
+        }
+    }
+
+    TEST_CASE("destroying a ring queue destroys the remaining objects") {
+        std::shared_ptr<int> val = std::make_shared<int>(10);
+        {
+            mpmcplusplus::RingQueue<std::shared_ptr<int>> q(8);
+            REQUIRE(q.push(val));
+            REQUIRE(q.push(val));
+            REQUIRE(val.use_count() == 3);
+        }
+        CHECK(val.use_count() == 1);
+    }
+
+    TEST_CASE("popping from empty ring queue with waiting and timeout") {
+        mpmcplusplus::RingQueue<int> q(16);
+        std::chrono::milliseconds duration(10);
+
+        int result;
+        REQUIRE_FALSE(q.wait_and_pop(result, duration));
+        CHECK_FALSE(q.pop(result));
+    }
+
+    TEST_CASE("single producer single consumer concurrently pushing and popping with waiting") {
+        mpmcplusplus::RingQueue<int> q(64);
+
+        std::thread pop_thread([&q]() {
+            int result;
+            for (int i = 0; i < 10000; ++i) {
+                REQUIRE(q.wait_and_pop(result));
+                REQUIRE(result == i);
+            }
+        });
+
+        std::thread push_thread([&q]() {
+            for (int i = 0; i < 10000; ++i) {
+                while (!q.push(i)) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+
+        pop_thread.join();
+        push_thread.join();
+
+        int result;
+        CHECK_FALSE(q.pop(result));
+    }
+
+    TEST_CASE("multi consumer multi producer concurrently pushing and popping with waiting") {
+        mpmcplusplus::RingQueue<int> q(64);
+        std::atomic<int> popped_count(0);
+        std::atomic<int> popped_sum(0);
+
+        auto pop = [&q, &popped_count, &popped_sum]() {
+            int result;
+            while (popped_count.fetch_add(1) < 30000) {
+                REQUIRE(q.wait_and_pop(result));
+                REQUIRE((result == 1 || result == 2 || result == 3));
+                popped_sum.fetch_add(result);
+            }
+        };
+
+        auto push = [&q](int val) {
+            for (int i = 0; i < 10000; ++i) {
+                while (!q.push(val)) {
+                    std::this_thread::yield();
+                }
+            }
+        };
+
+        std::thread pop_thread_1(pop);
+        std::thread pop_thread_2(pop);
+        std::thread pop_thread_3(pop);
+        std::thread push_thread_1(push, 1);
+        std::thread push_thread_2(push, 2);
+        std::thread push_thread_3(push, 3);
+
+        pop_thread_1.join();
+        pop_thread_2.join();
+        pop_thread_3.join();
+        push_thread_1.join();
+        push_thread_2.join();
+        push_thread_3.join();
+
+        CHECK(popped_sum == 60000);
+        int result;
+        CHECK_FALSE(q.pop(result));
+    }
+}
@@ -0,0 +1,221 @@
+/*
+ * test_segmented_queue.cpp - Test code for the mpmcplusplus segmented queue
+ * Copyright (C) 2021 James Triantafylos
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "doctest/doctest.h"
+
+#include <atomic>
+#include <memory>
+#include <thread>
+
+#include "mpmcplusplus/segmented_queue.h"
+
+TEST_SUITE("segmented queue") {
+    TEST_CASE("creating a segmented queue") { mpmcplusplus::SegmentedQueue<int> q; }
+
+    TEST_CASE("popping from empty segmented queue") {
+        mpmcplusplus::SegmentedQueue<int> q;
+
+        int result;
+        CHECK_FALSE(q.pop(result));
+    }
+
+    TEST_CASE("pushing and popping one lvalue") {
+        mpmcplusplus::SegmentedQueue<int> q;
+        const int val = 10;
+
+        REQUIRE(q.push(val));
+
+        int result;
+        REQUIRE(q.pop(result));
+        CHECK(result == val);
+        CHECK_FALSE(q.pop(result));
+    }
+
+    TEST_CASE("pushing and then popping multiple values across segments") {
+        mpmcplusplus::SegmentedQueue<int, 4> q;
+
+        for (int i = 0; i < 10000; ++i) {
+            REQUIRE(q.push(i));
+        }
+
+        int result;
+        for (int i = 0; i < 10000; ++i) {
+            REQUIRE(q.pop(result));
+            REQUIRE(result == i);
+        }
+        CHECK_FALSE(q.pop(result));
+    }
+
+    TEST_CASE("interleaved emplacing and popping recycles segments") {
+        mpmcplusplus::SegmentedQueue<std::unique_ptr<int>, 4> q;
+
+        std::unique_ptr<int> result;
+        for (int i = 0; i < 10000; ++i) {
+            REQUIRE(q.emplace(new int(i)));
+            REQUIRE(q.emplace(new int(i + 1)));
+            REQUIRE(q.emplace(new int(i + 2)));
+
+            REQUIRE(q.pop(result));
+            REQUIRE(*result == i);
+            REQUIRE(q.pop(result));
+            REQUIRE(*result == i + 1);
+            REQUIRE(q.pop(result));
+            REQUIRE(*result == i + 2);
+        }
+        CHECK_FALSE(q.pop(result));
+    }
+
+    TEST_CASE("destroying a segmented queue destroys the remaining objects") {
+        std::shared_ptr<int> val = std::make_shared<int>(10);
+        {
+            mpmcplusplus::SegmentedQueue<std::shared_ptr<int>, 4> q;
+            for (int i = 0; i < 10; ++i) {
+                REQUIRE(q.push(val));
+            }
+            std::shared_ptr<int> result;
+            for (int i = 0; i < 5; ++i) {
+                REQUIRE(q.pop(result));
+            }
+            result.reset();
+            REQUIRE(val.use_count() == 6);
+        }
+        CHECK(val.use_count() == 1);
+    }
+
+    TEST_CASE("producers are not held up by a producer stalled at the end of a segment") {
+        struct Gate {
+            std::atomic<bool> entered;
+            std::atomic<bool> open;
+        };
+
+        struct Gated {
+            int value;
+
+            Gated() : value(0) {}
+
+            Gated(int v, Gate* gate) : value(v) {
+                if (gate == nullptr) {
+                    return;
+                }
+                gate->entered = true;
+                while (!gate->open) {
+                    std::this_thread::yield();
+                }
+            }
+        };
+
+        mpmcplusplus::SegmentedQueue<Gated, 4> q;
+        Gate gate;
+        gate.entered = false;
+        gate.open = false;
+
+        for (int i = 0; i < 3; ++i) {
+            REQUIRE(q.emplace(i, nullptr));
+        }
+        // The stalled producer claims the last slot of the first segment, which makes it the one to link the next.
+        std::thread stalled_thread([&q, &gate]() { REQUIRE(q.emplace(3, &gate)); });
+        while (!gate.entered) {
+            std::this_thread::yield();
+        }
+
+        for (int i = 4; i < 100; ++i) {
+            REQUIRE(q.emplace(i, nullptr));
+        }
+        gate.open = true;
+        stalled_thread.join();
+
+        Gated result;
+        for (int i = 0; i < 100; ++i) {
+            REQUIRE(q.pop(result));
+            REQUIRE(result.value == i);
+        }
+        CHECK_FALSE(q.pop(result));
+    }
+
+    TEST_CASE("popping from empty segmented queue with waiting and timeout") {
+        mpmcplusplus::SegmentedQueue<int> q;
+        std::chrono::milliseconds duration(10);
+
+        int result;
+        REQUIRE_FALSE(q.wait_and_pop(result, duration));
+        CHECK_FALSE(q.pop(result));
+    }
+
+    TEST_CASE("single producer single consumer concurrently pushing and popping with waiting") {
+        mpmcplusplus::SegmentedQueue<int, 8> q;
+
+        std::thread pop_thread([&q]() {
+            int result;
+            for (int i = 0; i < 10000; ++i) {
+                REQUIRE(q.wait_and_pop(result));
+                REQUIRE(result == i);
+            }
+        });
+
+        std::thread push_thread([&q]() {
+            for (int i = 0; i < 10000; ++i) {
+                REQUIRE(q.push(i));
+            }
+        });
+
+        pop_thread.join();
+        push_thread.join();
+
+        int result;
+        CHECK_FALSE(q.pop(result));
+    }
+
+    TEST_CASE("multi consumer multi producer concurrently pushing and popping with waiting") {
+        mpmcplusplus::SegmentedQueue<int, 8> q;
+        std::atomic<int> popped_count(0);
+        std::atomic<int> popped_sum(0);
+
+        auto pop = [&q, &popped_count, &popped_sum]() {
+            int result;
+            while (popped_count.fetch_add(1) < 30000) {
+                REQUIRE(q.wait_and_pop(result));
+                REQUIRE((result == 1 || result == 2 || result == 3));
+                popped_sum.fetch_add(result);
+            }
+        };
+
+        auto push = [&q](int val) {
+            for (int i = 0; i < 10000; ++i) {
+                REQUIRE(q.push(val));
+            }
+        };
+
+        std::thread pop_thread_1(pop);
+        std::thread pop_thread_2(pop);
+        std::thread pop_thread_3(pop);
+        std::thread push_thread_1(push, 1);
+        std::thread push_thread_2(push, 2);
+        std::thread push_thread_3(push, 3);
+
+        pop_thread_1.join();
+        pop_thread_2.join();
+        pop_thread_3.join();
+        push_thread_1.join();
+        push_thread_2.join();
+        push_thread_3.join();
+
+        CHECK(popped_sum == 60000);
+        int result;
+        CHECK_FALSE(q.pop(result));
+    }
+}
@@ -0,0 +1,146 @@
+/*
+ * test_select.cpp - Test code for the mpmcplusplus queue select
+ * Copyright (C) 2021 James Triantafylos
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "doctest/doctest.h"
+
+#include <atomic>
+#include <functional>
+#include <thread>
+
+#include "mpmcplusplus/mpmcplusplus.h"
+#include "mpmcplusplus/select.h"
+
+TEST_SUITE("select") {
+    TEST_CASE("creating a select") {
+        mpmcplusplus::Queue<int> q0;
+        mpmcplusplus::Queue<int> q1;
+        mpmcplusplus::Select<mpmcplusplus::Queue<int>, mpmcplusplus::Queue<int>> s(q0, q1);
+    }
+
+    TEST_CASE("popping from empty queues") {
+        mpmcplusplus::Queue<int> q0;
+        mpmcplusplus::Queue<int> q1;
+        mpmcplusplus::Select<mpmcplusplus::Queue<int>, mpmcplusplus::Queue<int>> s(q0, q1);
+
+        std::size_t index;
+        int result;
+        CHECK_FALSE(s.pop(index, result));
+    }
+
+    TEST_CASE("popping reports the queue the object came from") {
+        mpmcplusplus::Queue<int> q0;
+        mpmcplusplus::Queue<int> q1;
+        mpmcplusplus::Select<mpmcplusplus::Queue<int>, mpmcplusplus::Queue<int>> s(q0, q1);
+
+        REQUIRE(q1.push(10));
+
+        std::size_t index;
+        int result;
+        REQUIRE(s.pop(index, result));
+        CHECK(index == 1);
+        CHECK(result == 10);
+        CHECK_FALSE(s.pop(index, result));
+    }
+
+    TEST_CASE("earlier queues take priority") {
+        mpmcplusplus::Queue<int> q0;
+        mpmcplusplus::Queue<int, mpmcplusplus::RingBuffer<int>> q1;
+        mpmcplusplus::Select<mpmcplusplus::Queue<int>, mpmcplusplus::Queue<int, mpmcplusplus::RingBuffer<int>>> s(q0,
+                                                                                                                   q1);
+
+        REQUIRE(q1.push(1));
+        REQUIRE(q1.push(2));
+        REQUIRE(q0.push(3));
+
+        std::size_t index;
+        int result;
+        REQUIRE(s.pop(index, result));
+        CHECK(index == 0);
+        CHECK(result == 3);
+        REQUIRE(s.pop(index, result));
+        CHECK(index == 1);
+        CHECK(result == 1);
+        REQUIRE(s.pop(index, result));
+        CHECK(index == 1);
+        CHECK(result == 2);
+    }
+
+    TEST_CASE("popping from empty queues with waiting and timeout") {
+        mpmcplusplus::Queue<int> q0;
+        mpmcplusplus::Queue<int> q1;
+        mpmcplusplus::Select<mpmcplusplus::Queue<int>, mpmcplusplus::Queue<int>> s(q0, q1);
+        std::chrono::milliseconds duration(10);
+
+        std::size_t index;
+        int result;
+        REQUIRE_FALSE(s.wait_and_pop(index, result, duration));
+        CHECK_FALSE(s.pop(index, result));
+    }
+
+    TEST_CASE("queues keep working after a select detaches") {
+        mpmcplusplus::Queue<int> q0;
+        {
+            mpmcplusplus::Select<mpmcplusplus::Queue<int>> s(q0);
+        }
+        REQUIRE(q0.push(1));
+
+        int result;
+        REQUIRE(q0.pop(result));
+        CHECK(result == 1);
+    }
+
+    TEST_CASE("waiting on several queues fed by concurrent producers") {
+        mpmcplusplus::Queue<int> control;
+        mpmcplusplus::Queue<int> data;
+        std::atomic<int> sums[2];
+        sums[0] = 0;
+        sums[1] = 0;
+        std::atomic<int> popped_count(0);
+
+        auto pop = [&control, &data, &sums, &popped_count]() {
+            mpmcplusplus::Select<mpmcplusplus::Queue<int>, mpmcplusplus::Queue<int>> s(control, data);
+            std::size_t index;
+            int result;
+            while (popped_count.fetch_add(1) < 20000) {
+                REQUIRE(s.wait_and_pop(index, result));
+                REQUIRE(index < 2);
+                REQUIRE(result == static_cast<int>(index) + 1);
+                sums[index].fetch_add(result);
+            }
+        };
+
+        auto push = [](mpmcplusplus::Queue<int>& q, int val) {
+            for (int i = 0; i < 10000; ++i) {
+                REQUIRE(q.push(val));
+            }
+        };
+
+        std::thread pop_thread_1(pop);
+        std::thread pop_thread_2(pop);
+        std::thread push_thread_1(push, std::ref(control), 1);
+        std::thread push_thread_2(push, std::ref(data), 2);
+
+        pop_thread_1.join();
+        pop_thread_2.join();
+        push_thread_1.join();
+        push_thread_2.join();
+
+        CHECK(sums[0] == 10000);
+        CHECK(sums[1] == 20000);
+    }
+}
@@ -0,0 +1,185 @@
+/*
+ * test_shared_memory_queue.cpp - Test code for the mpmcplusplus shared memory queue
+ * Copyright (C) 2021 James Triantafylos
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "doctest/doctest.h"
+
+#if defined(__linux__)
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <system_error>
+#include <thread>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "mpmcplusplus/shared_memory_queue.h"
+
+namespace {
+    std::string segment_name() {
+        static std::atomic<int> counter(0);
+        return "/mpmcplusplus_test_" + std::to_string(getpid()) + "_" + std::to_string(counter.fetch_add(1));
+    }
+
+    struct Message {
+        int producer;
+        int sequence;
+    };
+}
+
+TEST_SUITE("shared memory queue") {
+    TEST_CASE("creating a shared memory queue") {
+        const std::string name = segment_name();
+        {
+            mpmcplusplus::SharedMemoryQueue<int> q(name, 100);
+
+            CHECK(q.capacity() == 128);
+        }
+        CHECK(mpmcplusplus::SharedMemoryQueue<int>::unlink(name));
+        CHECK_FALSE(mpmcplusplus::SharedMemoryQueue<int>::unlink(name));
+    }
+
+    TEST_CASE("creating a shared memory queue that already exists") {
+        const std::string name = segment_name();
+        mpmcplusplus::SharedMemoryQueue<int> q(name, 16);
+
+        CHECK_THROWS_AS((mpmcplusplus::SharedMemoryQueue<int>(name, 16)), std::system_error);
+        mpmcplusplus::SharedMemoryQueue<int>::unlink(name);
+    }
+
+    TEST_CASE("opening a shared memory queue that does not exist") {
+        CHECK_THROWS_AS((mpmcplusplus::SharedMemoryQueue<int>(segment_name())), std::system_error);
+    }
+
+    TEST_CASE("opening a shared memory queue with the wrong object type") {
+        const std::string name = segment_name();
+        mpmcplusplus::SharedMemoryQueue<int> q(name, 16);
+
+        CHECK_THROWS_AS((mpmcplusplus::SharedMemoryQueue<Message>(name)), std::system_error);
+        mpmcplusplus::SharedMemoryQueue<int>::unlink(name);
+    }
+
+    TEST_CASE("popping from empty shared memory queue with waiting and timeout") {
+        const std::string name = segment_name();
+        mpmcplusplus::SharedMemoryQueue<int> q(name, 16);
+        std::chrono::milliseconds duration(10);
+
+        int result;
+        REQUIRE_FALSE(q.wait_and_pop(result, duration));
+        CHECK_FALSE(q.pop(result));
+        mpmcplusplus::SharedMemoryQueue<int>::unlink(name);
+    }
+
+    TEST_CASE("pushing through one mapping and popping through another") {
+        const std::string name = segment_name();
+        mpmcplusplus::SharedMemoryQueue<Message> producer(name, 4);
+        mpmcplusplus::SharedMemoryQueue<Message> consumer(name);
+        mpmcplusplus::SharedMemoryQueue<Message>::unlink(name);
+
+        CHECK(consumer.capacity() == 4);
+        for (int i = 0; i < 4; ++i) {
+            REQUIRE(producer.push(Message{0, i}));
+        }
+        CHECK_FALSE(producer.push(Message{0, 4}));
+
+        Message result;
+        for (int i = 0; i < 4; ++i) {
+            REQUIRE(consumer.pop(result));
+            REQUIRE(result.sequence == i);
+        }
+        CHECK_FALSE(consumer.pop(result));
+    }
+
+    TEST_CASE("multi consumer multi producer concurrently pushing and popping through separate mappings") {
+        const std::string name = segment_name();
+        mpmcplusplus::SharedMemoryQueue<int> q(name, 64);
+        std::atomic<int> popped_count(0);
+        std::atomic<int> popped_sum(0);
+
+        auto pop = [&name, &popped_count, &popped_sum]() {
+            mpmcplusplus::SharedMemoryQueue<int> consumer(name);
+            int result;
+            while (popped_count.fetch_add(1) < 30000) {
+                REQUIRE(consumer.wait_and_pop(result));
+                popped_sum.fetch_add(result);
+            }
+        };
+
+        auto push = [&name](int val) {
+            mpmcplusplus::SharedMemoryQueue<int> producer(name);
+            for (int i = 0; i < 10000; ++i) {
+                while (!producer.push(val)) {
+                    std::this_thread::yield();
+                }
+            }
+        };
+
+        std::thread pop_thread_1(pop);
+        std::thread pop_thread_2(pop);
+        std::thread pop_thread_3(pop);
+        std::thread push_thread_1(push, 1);
+        std::thread push_thread_2(push, 2);
+        std::thread push_thread_3(push, 3);
+
+        pop_thread_1.join();
+        pop_thread_2.join();
+        pop_thread_3.join();
+        push_thread_1.join();
+        push_thread_2.join();
+        push_thread_3.join();
+
+        CHECK(popped_sum == 60000);
+        int result;
+        CHECK_FALSE(q.pop(result));
+        mpmcplusplus::SharedMemoryQueue<int>::unlink(name);
+    }
+
+    TEST_CASE("waiting for an object pushed by another process") {
+        const std::string name = segment_name();
+        mpmcplusplus::SharedMemoryQueue<Message> q(name, 16);
+
+        const pid_t child = fork();
+        REQUIRE(child != -1);
+        if (child == 0) {
+            mpmcplusplus::SharedMemoryQueue<Message> producer(name);
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            for (int i = 0; i < 10000; ++i) {
+                while (!producer.push(Message{1, i})) {
+                    std::this_thread::yield();
+                }
+            }
+            _exit(0);
+        }
+
+        Message result;
+        for (int i = 0; i < 10000; ++i) {
+            REQUIRE(q.wait_and_pop(result));
+            REQUIRE(result.producer == 1);
+            REQUIRE(result.sequence == i);
+        }
+        int status;
+        REQUIRE(waitpid(child, &status, 0) == child);
+        CHECK(WIFEXITED(status));
+        CHECK(WEXITSTATUS(status) == 0);
+        CHECK_FALSE(q.pop(result));
+        mpmcplusplus::SharedMemoryQueue<Message>::unlink(name);
+    }
+}
+
+#endif
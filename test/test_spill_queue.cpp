@@ -0,0 +1,218 @@
+/*
+ * test_spill_queue.cpp - Test code for the mpmcplusplus spill queue
+ * Copyright (C) 2021 James Triantafylos
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "doctest/doctest.h"
+
+#if defined(__linux__)
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <system_error>
+#include <thread>
+
+#include "mpmcplusplus/spill_queue.h"
+
+namespace {
+    struct StringCodec {
+        std::size_t size(const std::string& object) const { return object.size(); }
+
+        void encode(const std::string& object, unsigned char* data) const {
+            std::memcpy(data, object.data(), object.size());
+        }
+
+        void decode(const unsigned char* data, std::size_t size, std::string& object) const {
+            object.assign(reinterpret_cast<const char*>(data), size);
+        }
+    };
+}
+
+TEST_SUITE("spill queue") {
+    TEST_CASE("creating a spill queue") {
+        mpmcplusplus::SpillQueue<int> q(16, "/tmp");
+
+        CHECK(q.size() == 0);
+        CHECK(q.spilled_size() == 0);
+    }
+
+    TEST_CASE("popping from empty spill queue") {
+        mpmcplusplus::SpillQueue<int> q(16, "/tmp");
+
+        int result;
+        CHECK_FALSE(q.pop(result));
+    }
+
+    TEST_CASE("popping from empty spill queue with waiting and timeout") {
+        mpmcplusplus::SpillQueue<int> q(16, "/tmp");
+        std::chrono::milliseconds duration(10);
+
+        int result;
+        REQUIRE_FALSE(q.wait_and_pop(result, duration));
+        CHECK_FALSE(q.pop(result));
+    }
+
+    TEST_CASE("spilling to a directory that does not exist") {
+        mpmcplusplus::SpillQueue<int> q(1, "/nonexistent/mpmcplusplus");
+
+        REQUIRE(q.push(1));
+        CHECK_THROWS_AS(q.push(2), std::system_error);
+        CHECK(q.size() == 1);
+    }
+
+    TEST_CASE("objects past the memory limit are spilled and popped in order") {
+        mpmcplusplus::SpillQueue<int> q(4, "/tmp", 64);
+
+        for (int i = 0; i < 100; ++i) {
+            REQUIRE(q.push(i));
+        }
+        CHECK(q.size() == 100);
+        CHECK(q.spilled_size() == 96);
+
+        int result;
+        for (int i = 0; i < 100; ++i) {
+            REQUIRE(q.pop(result));
+            REQUIRE(result == i);
+        }
+        CHECK_FALSE(q.pop(result));
+        CHECK(q.spilled_size() == 0);
+    }
+
+    TEST_CASE("spilled objects are paged back into memory as it frees up") {
+        mpmcplusplus::SpillQueue<int> q(2, "/tmp");
+
+        REQUIRE(q.push(1));
+        REQUIRE(q.push(2));
+        REQUIRE(q.push(3));
+        REQUIRE(q.push(4));
+        CHECK(q.spilled_size() == 2);
+
+        int result;
+        REQUIRE(q.pop(result));
+        CHECK(result == 1);
+        CHECK(q.spilled_size() == 1);
+        REQUIRE(q.push(5));
+        CHECK(q.spilled_size() == 2);
+
+        REQUIRE(q.pop(result));
+        CHECK(result == 2);
+        REQUIRE(q.pop(result));
+        CHECK(result == 3);
+        CHECK(q.spilled_size() == 0);
+
+        REQUIRE(q.pop(result));
+        CHECK(result == 4);
+        REQUIRE(q.push(6));
+        CHECK(q.spilled_size() == 0);
+        for (int i = 5; i <= 6; ++i) {
+            REQUIRE(q.pop(result));
+            CHECK(result == i);
+        }
+        CHECK_FALSE(q.pop(result));
+    }
+
+    TEST_CASE("emplacing past the memory limit") {
+        mpmcplusplus::SpillQueue<std::string, StringCodec> q(1, "/tmp");
+
+        REQUIRE(q.emplace(3, 'a'));
+        REQUIRE(q.emplace("bc"));
+        CHECK(q.spilled_size() == 1);
+
+        std::string result;
+        REQUIRE(q.pop(result));
+        CHECK(result == "aaa");
+        REQUIRE(q.pop(result));
+        CHECK(result == "bc");
+    }
+
+    TEST_CASE("a memory limit of zero spills every object") {
+        mpmcplusplus::SpillQueue<int> q(0, "/tmp", 4096);
+
+        for (int i = 0; i < 2000; ++i) {
+            REQUIRE(q.push(i));
+        }
+        CHECK(q.spilled_size() == 2000);
+
+        int result;
+        for (int i = 0; i < 2000; ++i) {
+            REQUIRE(q.pop(result));
+            REQUIRE(result == i);
+        }
+        CHECK_FALSE(q.pop(result));
+    }
+
+    TEST_CASE("spilling variable-length objects with a custom codec") {
+        mpmcplusplus::SpillQueue<std::string, StringCodec> q(1, "/tmp", 64);
+
+        for (int i = 0; i < 1000; ++i) {
+            REQUIRE(q.push(std::string(static_cast<std::size_t>(i % 100), static_cast<char>('a' + i % 26))));
+        }
+        REQUIRE(q.push(std::string(1000, 'z')));
+        CHECK(q.spilled_size() == 1000);
+
+        std::string result;
+        for (int i = 0; i < 1000; ++i) {
+            REQUIRE(q.pop(result));
+            REQUIRE(result == std::string(static_cast<std::size_t>(i % 100), static_cast<char>('a' + i % 26)));
+        }
+        REQUIRE(q.pop(result));
+        CHECK(result == std::string(1000, 'z'));
+        CHECK_FALSE(q.pop(result));
+    }
+
+    TEST_CASE("multi consumer multi producer concurrently pushing past the memory limit with waiting") {
+        mpmcplusplus::SpillQueue<int> q(100, "/tmp", 4096);
+        std::atomic<int> popped_count(0);
+        std::atomic<int> popped_sum(0);
+
+        auto pop = [&q, &popped_count, &popped_sum]() {
+            int result;
+            while (popped_count.fetch_add(1) < 30000) {
+                REQUIRE(q.wait_and_pop(result));
+                popped_sum.fetch_add(result);
+            }
+        };
+
+        auto push = [&q](int val) {
+            for (int i = 0; i < 10000; ++i) {
+                REQUIRE(q.push(val));
+            }
+        };
+
+        std::thread push_thread_1(push, 1);
+        std::thread push_thread_2(push, 2);
+        std::thread push_thread_3(push, 3);
+        std::thread pop_thread_1(pop);
+        std::thread pop_thread_2(pop);
+        std::thread pop_thread_3(pop);
+
+        pop_thread_1.join();
+        pop_thread_2.join();
+        pop_thread_3.join();
+        push_thread_1.join();
+        push_thread_2.join();
+        push_thread_3.join();
+
+        CHECK(popped_sum == 60000);
+        int result;
+        CHECK_FALSE(q.pop(result));
+        CHECK(q.spilled_size() == 0);
+    }
+}
+
+#endif
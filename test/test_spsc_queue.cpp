@@ -0,0 +1,161 @@
+/*
+ * test_spsc_queue.cpp - Test code for the mpmcplusplus single producer single consumer queue
+ * Copyright (C) 2021 James Triantafylos
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "doctest/doctest.h"
+
+#include <memory>
+#include <thread>
+
+#include "mpmcplusplus/spsc_queue.h"
+
+TEST_SUITE("spsc queue") {
+    TEST_CASE("creating an spsc queue") {
+        mpmcplusplus::SpscQueue<int> q(5);
+
+        CHECK(q.capacity() == 8);
+    }
+
+    TEST_CASE("popping from empty spsc queue") {
+        mpmcplusplus::SpscQueue<int> q(16);
+
+        int result;
+        CHECK_FALSE(q.pop(result));
+    }
+
+    TEST_CASE("pushing and popping one lvalue") {
+        mpmcplusplus::SpscQueue<int> q(16);
+        const int val = 10;
+
+        REQUIRE(q.push(val));
+
+        int result;
+        REQUIRE(q.pop(result));
+        CHECK(result == val);
+        CHECK_FALSE(q.pop(result));
+    }
+
+    TEST_CASE("pushing to a full spsc queue") {
+        mpmcplusplus::SpscQueue<int> q(4);
+
+        for (int i = 0; i < 4; ++i) {
+            REQUIRE(q.push(i));
+        }
+        CHECK_FALSE(q.push(4));
+
+        int result;
+        REQUIRE(q.pop(result));
+        CHECK(result == 0);
+        CHECK(q.push(4));
+    }
+
+    TEST_CASE("interleaved emplacing and popping wraps around the ring") {
+        mpmcplusplus::SpscQueue<std::unique_ptr<int>> q(4);
+
+        std::unique_ptr<int> result;
+        for (int i = 0; i < 10000; ++i) {
+            REQUIRE(q.emplace(new int(i)));
+            REQUIRE(q.emplace(new int(i + 1)));
+            REQUIRE(q.emplace(new int(i + 2)));
+
+            REQUIRE(q.pop(result));
+            REQUIRE(*result == i);
+            REQUIRE(q.pop(result));
+            REQUIRE(*result == i + 1);
+            REQUIRE(q.pop(result));
+            REQUIRE(*result == i + 2);
+        }
+        CHECK_FALSE(q.pop(result));
+    }
+
+    TEST_CASE("destroying an spsc queue destroys the remaining objects") {
+        std::shared_ptr<int> val = std::make_shared<int>(10);
+        {
+            mpmcplusplus::SpscQueue<std::shared_ptr<int>> q(8);
+            REQUIRE(q.push(val));
+            REQUIRE(q.push(val));
+            REQUIRE(val.use_count() == 3);
+        }
+        CHECK(val.use_count() == 1);
+    }
+
+    TEST_CASE("popping from empty spsc queue with waiting and timeout") {
+        mpmcplusplus::SpscQueue<int> q(16);
+        std::chrono::milliseconds duration(10);
+
+        int result;
+        REQUIRE_FALSE(q.wait_and_pop(result, duration));
+        CHECK_FALSE(q.pop(result));
+    }
+
+    TEST_CASE("single producer single consumer concurrently pushing and popping") {
+        mpmcplusplus::SpscQueue<int> q(64);
+
+        std::thread pop_thread([&q]() {
+            int popped_count = 0;
+            int result;
+            while (popped_count < 100000) {
+                if (q.pop(result)) {
+                    REQUIRE(result == popped_count);
+                    popped_count++;
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        });
+
+        std::thread push_thread([&q]() {
+            for (int i = 0; i < 100000; ++i) {
+                while (!q.push(i)) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+
+        pop_thread.join();
+        push_thread.join();
+
+        int result;
+        CHECK_FALSE(q.pop(result));
+    }
+
+    TEST_CASE("single producer single consumer concurrently pushing and popping with waiting") {
+        mpmcplusplus::SpscQueue<int> q(64);
+
+        std::thread pop_thread([&q]() {
+            int result;
+            for (int i = 0; i < 100000; ++i) {
+                REQUIRE(q.wait_and_pop(result));
+                REQUIRE(result == i);
+            }
+        });
+
+        std::thread push_thread([&q]() {
+            for (int i = 0; i < 100000; ++i) {
+                while (!q.push(i)) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+
+        pop_thread.join();
+        push_thread.join();
+
+        int result;
+        CHECK_FALSE(q.pop(result));
+    }
+}
@@ -0,0 +1,170 @@
+/*
+ * test_two_lock_queue.cpp - Test code for the mpmcplusplus two-lock queue
+ * Copyright (C) 2021 James Triantafylos
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "doctest/doctest.h"
+
+#include <atomic>
+#include <memory>
+#include <thread>
+
+#include "mpmcplusplus/two_lock_queue.h"
+
+TEST_SUITE("two lock queue") {
+    TEST_CASE("creating a two lock queue") { mpmcplusplus::TwoLockQueue<int> q; }
+
+    TEST_CASE("popping from empty two lock queue") {
+        mpmcplusplus::TwoLockQueue<int> q;
+
+        int result;
+        CHECK_FALSE(q.pop(result));
+    }
+
+    TEST_CASE("pushing and popping one lvalue") {
+        mpmcplusplus::TwoLockQueue<int> q;
+        const int val = 10;
+
+        REQUIRE(q.push(val));
+
+        int result;
+        REQUIRE(q.pop(result));
+        CHECK(result == val);
+        CHECK_FALSE(q.pop(result));
+    }
+
+    TEST_CASE("pushing and then popping multiple values") {
+        mpmcplusplus::TwoLockQueue<int> q;
+
+        for (int i = 0; i < 10000; ++i) {
+            REQUIRE(q.push(i));
+        }
+
+        int result;
+        for (int i = 0; i < 10000; ++i) {
+            REQUIRE(q.pop(result));
+            REQUIRE(result == i);
+        }
+        CHECK_FALSE(q.pop(result));
+    }
+
+    TEST_CASE("emplacing and popping multiple values") {
+        mpmcplusplus::TwoLockQueue<std::unique_ptr<int>> q;
+
+        for (int i = 0; i < 10000; ++i) {
+            REQUIRE(q.emplace(new int(i)));
+        }
+
+        std::unique_ptr<int> result;
+        for (int i = 0; i < 10000; ++i) {
+            REQUIRE(q.pop(result));
+            REQUIRE(*result == i);
+        }
+        CHECK_FALSE(q.pop(result));
+    }
+
+    TEST_CASE("destroying a two lock queue destroys the remaining objects") {
+        std::shared_ptr<int> val = std::make_shared<int>(10);
+        {
+            mpmcplusplus::TwoLockQueue<std::shared_ptr<int>> q;
+            REQUIRE(q.push(val));
+            REQUIRE(q.push(val));
+            REQUIRE(val.use_count() == 3);
+        }
+        CHECK(val.use_count() == 1);
+    }
+
+    TEST_CASE("popping from empty two lock queue with waiting and timeout") {
+        mpmcplusplus::TwoLockQueue<int> q;
+        std::chrono::milliseconds duration(10);
+
+        int result;
+        REQUIRE_FALSE(q.wait_and_pop(result, duration));
+        CHECK_FALSE(q.pop(result));
+    }
+
+    TEST_CASE("multi producer single consumer concurrently pushing and popping with waiting") {
+        mpmcplusplus::TwoLockQueue<int> q;
+
+        auto push = [&q](int producer) {
+            for (int i = 0; i < 10000; ++i) {
+                REQUIRE(q.push(producer * 10000 + i));
+            }
+        };
+
+        std::thread pop_thread([&q]() {
+            int next_expected[3] = {0, 10000, 20000};
+            int result;
+            for (int i = 0; i < 30000; ++i) {
+                REQUIRE(q.wait_and_pop(result));
+                int producer = result / 10000;
+                REQUIRE(result == next_expected[producer]);
+                next_expected[producer]++;
+            }
+        });
+
+        std::thread push_thread_1(push, 0);
+        std::thread push_thread_2(push, 1);
+        std::thread push_thread_3(push, 2);
+
+        pop_thread.join();
+        push_thread_1.join();
+        push_thread_2.join();
+        push_thread_3.join();
+
+        int result;
+        CHECK_FALSE(q.pop(result));
+    }
+
+    TEST_CASE("multi consumer multi producer concurrently pushing and popping with waiting") {
+        mpmcplusplus::TwoLockQueue<int> q;
+        std::atomic<int> popped_count(0);
+        std::atomic<int> popped_sum(0);
+
+        auto pop = [&q, &popped_count, &popped_sum]() {
+            int result;
+            while (popped_count.fetch_add(1) < 30000) {
+                REQUIRE(q.wait_and_pop(result));
+                REQUIRE((result == 1 || result == 2 || result == 3));
+                popped_sum.fetch_add(result);
+            }
+        };
+
+        auto push = [&q](int val) {
+            for (int i = 0; i < 10000; ++i) {
+                REQUIRE(q.push(val));
+            }
+        };
+
+        std::thread pop_thread_1(pop);
+        std::thread pop_thread_2(pop);
+        std::thread pop_thread_3(pop);
+        std::thread push_thread_1(push, 1);
+        std::thread push_thread_2(push, 2);
+        std::thread push_thread_3(push, 3);
+
+        pop_thread_1.join();
+        pop_thread_2.join();
+        pop_thread_3.join();
+        push_thread_1.join();
+        push_thread_2.join();
+        push_thread_3.join();
+
+        CHECK(popped_sum == 60000);
+        int result;
+        CHECK_FALSE(q.pop(result));
+    }
+}
@@ -0,0 +1,182 @@
+/*
+ * test_work_stealing_deque.cpp - Test code for the mpmcplusplus work-stealing deque
+ * Copyright (C) 2021 James Triantafylos
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "doctest/doctest.h"
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "mpmcplusplus/work_stealing_deque.h"
+
+TEST_SUITE("work stealing deque") {
+    TEST_CASE("creating a work stealing deque") { mpmcplusplus::WorkStealingDeque<int> d; }
+
+    TEST_CASE("popping and stealing from empty work stealing deque") {
+        mpmcplusplus::WorkStealingDeque<int> d;
+
+        int result;
+        CHECK_FALSE(d.pop(result));
+        CHECK_FALSE(d.steal(result));
+    }
+
+    TEST_CASE("popping returns the most recently pushed value") {
+        mpmcplusplus::WorkStealingDeque<int> d(4);
+
+        for (int i = 0; i < 10000; ++i) {
+            REQUIRE(d.push(i));
+        }
+
+        int result;
+        for (int i = 9999; i >= 0; --i) {
+            REQUIRE(d.pop(result));
+            REQUIRE(result == i);
+        }
+        CHECK_FALSE(d.pop(result));
+    }
+
+    TEST_CASE("stealing returns the least recently pushed value") {
+        mpmcplusplus::WorkStealingDeque<std::unique_ptr<int>> d(4);
+
+        for (int i = 0; i < 10000; ++i) {
+            REQUIRE(d.emplace(new int(i)));
+        }
+
+        std::unique_ptr<int> result;
+        for (int i = 0; i < 10000; ++i) {
+            REQUIRE(d.steal(result));
+            REQUIRE(*result == i);
+        }
+        CHECK_FALSE(d.steal(result));
+    }
+
+    TEST_CASE("destroying a work stealing deque destroys the remaining objects") {
+        std::shared_ptr<int> val = std::make_shared<int>(10);
+        {
+            mpmcplusplus::WorkStealingDeque<std::shared_ptr<int>> d(2);
+            for (int i = 0; i < 5; ++i) {
+                REQUIRE(d.push(val));
+            }
+            REQUIRE(val.use_count() == 6);
+        }
+        CHECK(val.use_count() == 1);
+    }
+
+    TEST_CASE("owner popping while thieves steal runs every task exactly once") {
+        mpmcplusplus::WorkStealingDeque<std::function<void()>> d(8);
+        std::vector<std::atomic<int>> runs(30000);
+        for (std::atomic<int>& run : runs) {
+            run.store(0);
+        }
+        std::atomic<int> executed(0);
+        std::atomic<bool> done(false);
+
+        auto steal = [&d, &executed, &done]() {
+            std::function<void()> task;
+            while (!done.load()) {
+                if (d.steal(task)) {
+                    task();
+                    executed.fetch_add(1);
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        };
+
+        std::thread steal_thread_1(steal);
+        std::thread steal_thread_2(steal);
+
+        std::function<void()> task;
+        for (int i = 0; i < 30000; ++i) {
+            std::atomic<int>* run = &runs[i];
+            REQUIRE(d.push([run]() { run->fetch_add(1); }));
+            if (i % 3 == 0 && d.pop(task)) {
+                task();
+                executed.fetch_add(1);
+            }
+        }
+        while (d.pop(task)) {
+            task();
+            executed.fetch_add(1);
+        }
+        while (executed.load() < 30000) {
+            std::this_thread::yield();
+        }
+        done.store(true);
+
+        steal_thread_1.join();
+        steal_thread_2.join();
+
+        for (std::atomic<int>& run : runs) {
+            REQUIRE(run.load() == 1);
+        }
+        CHECK_FALSE(d.steal(task));
+    }
+
+    TEST_CASE("owner popping while thieves steal small objects stored in the ring") {
+        mpmcplusplus::WorkStealingDeque<std::atomic<int>*> d(8);
+        std::vector<std::atomic<int>> runs(30000);
+        for (std::atomic<int>& run : runs) {
+            run.store(0);
+        }
+        std::atomic<int> executed(0);
+        std::atomic<bool> done(false);
+
+        auto steal = [&d, &executed, &done]() {
+            std::atomic<int>* run;
+            while (!done.load()) {
+                if (d.steal(run)) {
+                    run->fetch_add(1);
+                    executed.fetch_add(1);
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        };
+
+        std::thread steal_thread_1(steal);
+        std::thread steal_thread_2(steal);
+
+        std::atomic<int>* run;
+        for (int i = 0; i < 30000; ++i) {
+            REQUIRE(d.push(&runs[static_cast<std::size_t>(i)]));
+            if (i % 3 == 0 && d.pop(run)) {
+                run->fetch_add(1);
+                executed.fetch_add(1);
+            }
+        }
+        while (d.pop(run)) {
+            run->fetch_add(1);
+            executed.fetch_add(1);
+        }
+        while (executed.load() < 30000) {
+            std::this_thread::yield();
+        }
+        done.store(true);
+
+        steal_thread_1.join();
+        steal_thread_2.join();
+
+        for (std::atomic<int>& count : runs) {
+            REQUIRE(count.load() == 1);
+        }
+        CHECK_FALSE(d.steal(run));
+    }
+}